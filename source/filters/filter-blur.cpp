@@ -18,14 +18,18 @@
  */
 
 #include "filter-blur.hpp"
+#include <algorithm>
 #include <cfloat>
 #include <cinttypes>
 #include <cmath>
+#include <cstring>
 #include <map>
 #include <stdexcept>
+#include <typeinfo>
 #include "gfx/blur/gfx-blur-box-linear.hpp"
 #include "gfx/blur/gfx-blur-box.hpp"
 #include "gfx/blur/gfx-blur-dual-filtering.hpp"
+#include "gfx/blur/gfx-blur-gaussian-box.hpp"
 #include "gfx/blur/gfx-blur-gaussian-linear.hpp"
 #include "gfx/blur/gfx-blur-gaussian.hpp"
 #include "obs/gs/gs-helper.hpp"
@@ -59,7 +63,15 @@
 #define ST_STEPSCALE "Filter.Blur.StepScale"
 #define ST_STEPSCALE_X "Filter.Blur.StepScale.X"
 #define ST_STEPSCALE_Y "Filter.Blur.StepScale.Y"
+#define ST_MULTIPASS "Filter.Blur.MultiPass"
+#define ST_RESOLUTION "Filter.Blur.Resolution"
+#define ST_RESOLUTION_FULL "Filter.Blur.Resolution.Full"
+#define ST_RESOLUTION_HALF "Filter.Blur.Resolution.Half"
+#define ST_RESOLUTION_QUARTER "Filter.Blur.Resolution.Quarter"
 #define ST_MASK "Filter.Blur.Mask"
+#define ST_MASK_MODE "Filter.Blur.Mask.Mode"
+#define ST_MASK_MODE_MIX "Filter.Blur.Mask.Mode.Mix"
+#define ST_MASK_MODE_SIZE "Filter.Blur.Mask.Mode.Size"
 #define ST_MASK_TYPE "Filter.Blur.Mask.Type"
 #define ST_MASK_TYPE_REGION "Filter.Blur.Mask.Type.Region"
 #define ST_MASK_TYPE_IMAGE "Filter.Blur.Mask.Type.Image"
@@ -92,6 +104,7 @@ static std::map<std::string, local_blur_type_t> list_of_types = {
 	{"gaussian", {&::gfx::blur::gaussian_factory::get, S_BLUR_TYPE_GAUSSIAN}},
 	{"gaussian_linear", {&::gfx::blur::gaussian_linear_factory::get, S_BLUR_TYPE_GAUSSIAN_LINEAR}},
 	{"dual_filtering", {&::gfx::blur::dual_filtering_factory::get, S_BLUR_TYPE_DUALFILTERING}},
+	{"gaussian_box", {&::gfx::blur::gaussian_box_factory::get, S_BLUR_TYPE_GAUSSIAN_BOX}},
 };
 static std::map<std::string, local_blur_subtype_t> list_of_subtypes = {
 	{"area", {::gfx::blur::type::Area, S_BLUR_SUBTYPE_AREA}},
@@ -100,6 +113,60 @@ static std::map<std::string, local_blur_subtype_t> list_of_subtypes = {
 	{"zoom", {::gfx::blur::type::Zoom, S_BLUR_SUBTYPE_ZOOM}},
 };
 
+// Source Mirror, which draws the mirrored source unmodified unless it rescales it.
+#define MIRROR_ID "obs-stream-effects-source-mirror"
+#define MIRROR_SOURCE "Source.Mirror.Source"
+#define MIRROR_SCALING "Source.Mirror.Scaling"
+#define MIRROR_MAX_DEPTH 8
+
+static void has_video_filters_cb(obs_source_t*, obs_source_t* filter, void* param)
+{
+	if (obs_source_enabled(filter) && ((obs_source_get_output_flags(filter) & OBS_SOURCE_VIDEO) != 0)) {
+		*reinterpret_cast<bool*>(param) = true;
+	}
+}
+
+// Find the source whose content a filter receives as input. Filters further down the chain receive the output of
+//  the previous filter, which is unique to this chain. The first filter receives the unfiltered output of its
+//  parent. For a mirror that is the filtered output of the mirrored source, which only equals its unfiltered output
+//  if it has no video filters, so mirrors are only resolved in that case. Blurs on several mirrors of one source, or
+//  on the source itself, can then share a single result.
+static obs_source_t* resolve_input(obs_source_t* parent, obs_source_t* target)
+{
+	if (target != parent) {
+		return target;
+	}
+
+	obs_source_t* input = parent;
+	for (size_t depth = 0; input && (depth < MIRROR_MAX_DEPTH); depth++) {
+		const char* id = obs_source_get_id(input);
+		if (!id || (strcmp(id, MIRROR_ID) != 0)) {
+			break;
+		}
+
+		obs_data_t*   settings = obs_source_get_settings(input);
+		obs_source_t* mirrored = nullptr;
+		if (settings && !obs_data_get_bool(settings, MIRROR_SCALING)) {
+			mirrored = obs_get_source_by_name(obs_data_get_string(settings, MIRROR_SOURCE));
+		}
+		obs_data_release(settings);
+		if (!mirrored) {
+			break;
+		}
+
+		bool filtered = false;
+		obs_source_enum_filters(mirrored, has_video_filters_cb, &filtered);
+
+		// Only the identity is needed, the mirror keeps the source alive.
+		obs_source_release(mirrored);
+		if (filtered) {
+			break;
+		}
+		input = mirrored;
+	}
+	return input;
+}
+
 static std::shared_ptr<filter::blur::blur_factory> factory_instance = nullptr;
 
 void filter::blur::blur_factory::initialize()
@@ -151,15 +218,6 @@ void filter::blur::blur_factory::on_list_fill()
 {
 	auto gctx = gs::context();
 
-	{
-		char* file = obs_module_file("effects/color-conversion.effect");
-		try {
-			_color_converter_effect = gs::effect::create(file);
-		} catch (std::runtime_error& ex) {
-			P_LOG_ERROR("<filter-blur> Loading _effect '%s' failed with error(s): %s", file, ex.what());
-		}
-		bfree(file);
-	}
 	{
 		char* file = obs_module_file("effects/mask.effect");
 		try {
@@ -174,8 +232,8 @@ void filter::blur::blur_factory::on_list_fill()
 void filter::blur::blur_factory::on_list_empty()
 {
 	auto gctx = gs::context();
-	_color_converter_effect.reset();
 	_mask_effect.reset();
+	_blur_cache.clear();
 }
 
 std::string const& filter::blur::blur_factory::get_translation(std::string const key)
@@ -222,9 +280,12 @@ void filter::blur::blur_factory::get_defaults(obs_data_t* data)
 	obs_data_set_default_bool(data, ST_STEPSCALE, false);
 	obs_data_set_default_double(data, ST_STEPSCALE_X, 1.);
 	obs_data_set_default_double(data, ST_STEPSCALE_Y, 1.);
+	obs_data_set_default_bool(data, ST_MULTIPASS, false);
+	obs_data_set_default_int(data, ST_RESOLUTION, 1);
 
 	// Masking
 	obs_data_set_default_bool(data, ST_MASK, false);
+	obs_data_set_default_int(data, ST_MASK_MODE, mask_mode::Mix);
 	obs_data_set_default_int(data, ST_MASK_TYPE, mask_type::Region);
 	obs_data_set_default_double(data, ST_MASK_REGION_LEFT, 0.0);
 	obs_data_set_default_double(data, ST_MASK_REGION_RIGHT, 0.0);
@@ -293,25 +354,49 @@ void filter::blur::blur_factory::video_render(void* inptr, gs_effect_t* effect)
 	reinterpret_cast<filter::blur::blur_instance*>(inptr)->video_render(effect);
 }
 
-std::shared_ptr<gs::effect> filter::blur::blur_factory::get_color_converter_effect()
+std::shared_ptr<gs::effect> filter::blur::blur_factory::get_mask_effect()
 {
-	return _color_converter_effect;
+	return _mask_effect;
 }
 
-std::shared_ptr<gs::effect> filter::blur::blur_factory::get_mask_effect()
+std::shared_ptr<gs::texture> filter::blur::blur_factory::get_cached_blur(blur_cache_key_t const& key, uint64_t frame)
 {
-	return _mask_effect;
+	auto found = _blur_cache.find(key);
+	if ((found == _blur_cache.end()) || (found->second.frame != frame)) {
+		return nullptr;
+	}
+	return found->second.texture;
+}
+
+void filter::blur::blur_factory::set_cached_blur(blur_cache_key_t const& key, uint64_t frame,
+												 std::shared_ptr<::gfx::blur::base> blur,
+												 std::shared_ptr<gs::texture>       texture)
+{
+	// Results from older frames can never be hit again, and would keep their blur alive.
+	for (auto iter = _blur_cache.begin(); iter != _blur_cache.end();) {
+		if (iter->second.frame != frame) {
+			iter = _blur_cache.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+
+	_blur_cache[key] = {frame, blur, texture};
 }
 
 filter::blur::blur_instance::blur_instance(obs_data_t* settings, obs_source_t* parent)
-	: _self(parent), _source_rendered(false), _output_rendered(false)
+	: _self(parent), _input(nullptr), _source_rendered(false), _source_divisor(1), _output_rendered(false)
 {
 	_self = parent;
 
 	// Create RenderTargets
 	try {
 		this->_source_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		this->_output_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+		this->_size_map_rt = std::make_shared<gs::rendertarget>(GS_R8, GS_ZS_NONE);
+		for (auto& rt : this->_scaled_rt) {
+			rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+		}
+		this->_probe = std::make_shared<gfx::texture_probe>();
 	} catch (const std::exception& ex) {
 		P_LOG_ERROR("<filter-blur:%s> Failed to create rendertargets, error %s.", obs_source_get_name(_self),
 					ex.what());
@@ -322,6 +407,7 @@ filter::blur::blur_instance::blur_instance(obs_data_t* settings, obs_source_t* p
 
 filter::blur::blur_instance::~blur_instance()
 {
+	this->_probe.reset();
 	this->_mask.source.source_texture.reset();
 	this->_source_rt.reset();
 	this->_output_texture.reset();
@@ -467,6 +553,12 @@ bool filter::blur::blur_instance::modified_properties(void*, obs_properties_t* p
 		} else if (type_found->first == "gaussian_linear") {
 			obs_property_set_long_description(obs_properties_get(props, ST_TYPE),
 											  D_TRANSLATE(D_DESC(S_BLUR_TYPE_GAUSSIAN_LINEAR)));
+		} else if (type_found->first == "dual_filtering") {
+			obs_property_set_long_description(obs_properties_get(props, ST_TYPE),
+											  D_TRANSLATE(D_DESC(S_BLUR_TYPE_DUALFILTERING)));
+		} else if (type_found->first == "gaussian_box") {
+			obs_property_set_long_description(obs_properties_get(props, ST_TYPE),
+											  D_TRANSLATE(D_DESC(S_BLUR_TYPE_GAUSSIAN_BOX)));
 		}
 	} else {
 		obs_property_set_long_description(obs_properties_get(props, ST_TYPE), D_TRANSLATE(D_DESC(ST_TYPE)));
@@ -497,6 +589,7 @@ bool filter::blur::blur_instance::modified_properties(void*, obs_properties_t* p
 								  || (subtype_found->second.type == ::gfx::blur::type::Zoom);
 		bool has_stepscale_support = type_found->second.fn().is_step_scale_supported(subtype_found->second.type);
 		bool show_scaling          = obs_data_get_bool(settings, ST_STEPSCALE) && has_stepscale_support;
+		bool has_multipass_support = type_found->second.fn().is_multipass_supported(subtype_found->second.type);
 
 		/// Size
 		p = obs_properties_get(props, ST_SIZE);
@@ -527,6 +620,9 @@ bool filter::blur::blur_instance::modified_properties(void*, obs_properties_t* p
 		obs_property_float_set_limits(p, type_found->second.fn().get_min_step_scale_x(subtype_found->second.type),
 									  type_found->second.fn().get_max_step_scale_x(subtype_found->second.type),
 									  type_found->second.fn().get_step_step_scale_x(subtype_found->second.type));
+
+		/// Multi-Pass
+		obs_property_set_visible(obs_properties_get(props, ST_MULTIPASS), has_multipass_support);
 	}
 
 	{ // Masking
@@ -535,6 +631,8 @@ bool filter::blur::blur_instance::modified_properties(void*, obs_properties_t* p
 		bool      show_region = (mtype == mask_type::Region) && show_mask;
 		bool      show_image  = (mtype == mask_type::Image) && show_mask;
 		bool      show_source = (mtype == mask_type::Source) && show_mask;
+		bool      show_mode   = show_mask && type_found->second.fn().is_size_map_supported(subtype_found->second.type);
+		obs_property_set_visible(obs_properties_get(props, ST_MASK_MODE), show_mode);
 		obs_property_set_visible(obs_properties_get(props, ST_MASK_TYPE), show_mask);
 		obs_property_set_visible(obs_properties_get(props, ST_MASK_REGION_LEFT), show_region);
 		obs_property_set_visible(obs_properties_get(props, ST_MASK_REGION_TOP), show_region);
@@ -599,6 +697,78 @@ void filter::blur::blur_instance::translate_old_settings(obs_data_t* settings)
 	obs_data_set_int(settings, S_VERSION, STREAMEFFECTS_VERSION);
 }
 
+std::string filter::blur::blur_instance::get_mask_technique()
+{
+	switch (this->_mask.type) {
+	case Region:
+		if (this->_mask.region.feather > std::numeric_limits<float_t>::epsilon()) {
+			if (this->_mask.region.invert) {
+				return "RegionFeatherInverted";
+			} else {
+				return "RegionFeather";
+			}
+		} else {
+			if (this->_mask.region.invert) {
+				return "RegionInverted";
+			} else {
+				return "Region";
+			}
+		}
+	case Image:
+	case Source:
+		return "Image";
+	}
+	return "";
+}
+
+std::shared_ptr<gs::texture> filter::blur::blur_instance::render_size_map(uint32_t width, uint32_t height)
+{
+	std::shared_ptr<gs::effect> mask_effect = blur_factory::get()->get_mask_effect();
+	std::string                 technique   = get_mask_technique() + "Size";
+	apply_mask_parameters(mask_effect, _source_texture->get_object(), nullptr);
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	{
+		auto op = _size_map_rt->render(width, height);
+		gs_ortho(0, (float)width, 0, (float)height, -1, 1);
+		while (gs_effect_loop(mask_effect->get_object(), technique.c_str())) {
+			gs_draw_sprite(nullptr, 0, width, height);
+		}
+	}
+
+	gs_blend_state_pop();
+
+	return _size_map_rt->get_texture();
+}
+
+filter::blur::blur_cache_key_t filter::blur::blur_instance::get_cache_key(obs_source_t* input)
+{
+	auto& blur = *_blur;
+	return blur_cache_key_t{input,
+							std::type_index(typeid(blur)),
+							_blur->get_type(),
+							_blur_size,
+							_blur_angle,
+							_blur_center.first,
+							_blur_center.second,
+							_blur_step_scaling ? _blur_step_scale.first : 1.,
+							_blur_step_scaling ? _blur_step_scale.second : 1.,
+							_blur_multipass,
+							_blur_resolution};
+}
+
 obs_properties_t* filter::blur::blur_instance::get_properties()
 {
 	obs_properties_t* pr = obs_properties_create();
@@ -614,6 +784,7 @@ obs_properties_t* filter::blur::blur_instance::get_properties()
 		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_GAUSSIAN), "gaussian");
 		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_GAUSSIAN_LINEAR), "gaussian_linear");
 		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_DUALFILTERING), "dual_filtering");
+		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_GAUSSIAN_BOX), "gaussian_box");
 
 		p = obs_properties_add_list(pr, ST_SUBTYPE, D_TRANSLATE(ST_SUBTYPE), OBS_COMBO_TYPE_LIST,
 									OBS_COMBO_FORMAT_STRING);
@@ -645,6 +816,16 @@ obs_properties_t* filter::blur::blur_instance::get_properties()
 		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_STEPSCALE_X)));
 		p = obs_properties_add_float_slider(pr, ST_STEPSCALE_Y, D_TRANSLATE(ST_STEPSCALE_Y), 0.0, 1000.0, 0.01);
 		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_STEPSCALE_Y)));
+
+		p = obs_properties_add_bool(pr, ST_MULTIPASS, D_TRANSLATE(ST_MULTIPASS));
+		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_MULTIPASS)));
+
+		p = obs_properties_add_list(pr, ST_RESOLUTION, D_TRANSLATE(ST_RESOLUTION), OBS_COMBO_TYPE_LIST,
+									OBS_COMBO_FORMAT_INT);
+		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_RESOLUTION)));
+		obs_property_list_add_int(p, D_TRANSLATE(ST_RESOLUTION_FULL), 1);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_RESOLUTION_HALF), 2);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_RESOLUTION_QUARTER), 4);
 	}
 
 	// Masking
@@ -652,6 +833,11 @@ obs_properties_t* filter::blur::blur_instance::get_properties()
 		p = obs_properties_add_bool(pr, ST_MASK, D_TRANSLATE(ST_MASK));
 		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_MASK)));
 		obs_property_set_modified_callback2(p, modified_properties, this);
+		p = obs_properties_add_list(pr, ST_MASK_MODE, D_TRANSLATE(ST_MASK_MODE), OBS_COMBO_TYPE_LIST,
+									OBS_COMBO_FORMAT_INT);
+		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_MASK_MODE)));
+		obs_property_list_add_int(p, D_TRANSLATE(ST_MASK_MODE_MIX), mask_mode::Mix);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_MASK_MODE_SIZE), mask_mode::Size);
 		p = obs_properties_add_list(pr, ST_MASK_TYPE, D_TRANSLATE(ST_MASK_TYPE), OBS_COMBO_TYPE_LIST,
 									OBS_COMBO_FORMAT_INT);
 		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_MASK_TYPE)));
@@ -747,11 +933,21 @@ void filter::blur::blur_instance::update(obs_data_t* settings)
 		this->_blur_step_scaling      = obs_data_get_bool(settings, ST_STEPSCALE);
 		this->_blur_step_scale.first  = obs_data_get_double(settings, ST_STEPSCALE_X) / 100.0;
 		this->_blur_step_scale.second = obs_data_get_double(settings, ST_STEPSCALE_Y) / 100.0;
+
+		// Multi-Pass
+		this->_blur_multipass = obs_data_get_bool(settings, ST_MULTIPASS);
+
+		// Resolution
+		this->_blur_resolution = uint32_t(obs_data_get_int(settings, ST_RESOLUTION));
+		if ((this->_blur_resolution != 2) && (this->_blur_resolution != 4)) {
+			this->_blur_resolution = 1;
+		}
 	}
 
 	{ // Masking
 		_mask.enabled = obs_data_get_bool(settings, ST_MASK);
 		if (_mask.enabled) {
+			_mask.mode = static_cast<mask_mode>(obs_data_get_int(settings, ST_MASK_MODE));
 			_mask.type = static_cast<mask_type>(obs_data_get_int(settings, ST_MASK_TYPE));
 			switch (_mask.type) {
 			case mask_type::Region:
@@ -806,7 +1002,17 @@ void filter::blur::blur_instance::video_tick(float)
 {
 	// Blur
 	if (_blur) {
-		_blur->set_size(_blur_size);
+		// The blur runs on a reduced copy of the source, so the size has to shrink with it. Dual Filtering already
+		//  halves the resolution per iteration, so for it the reduction replaces iterations instead.
+		double_t size = _blur_size;
+		if (_blur_resolution > 1) {
+			if (std::dynamic_pointer_cast<::gfx::blur::dual_filtering>(_blur)) {
+				size = std::max(size - log2(double_t(_blur_resolution)), 0.);
+			} else {
+				size = size / double_t(_blur_resolution);
+			}
+		}
+		_blur->set_size(size);
 		if (_blur_step_scaling) {
 			_blur->set_step_scale(_blur_step_scale.first, _blur_step_scale.second);
 		} else {
@@ -821,6 +1027,12 @@ void filter::blur::blur_instance::video_tick(float)
 			auto obj = std::dynamic_pointer_cast<::gfx::blur::base_center>(_blur);
 			obj->set_center(_blur_center.first, _blur_center.second);
 		}
+		{
+			auto obj = std::dynamic_pointer_cast<::gfx::blur::base_multipass>(_blur);
+			if (obj) {
+				obj->set_multipass(_blur_multipass);
+			}
+		}
 	}
 
 	// Load Mask
@@ -847,11 +1059,14 @@ void filter::blur::blur_instance::video_tick(float)
 		}
 	}
 
+	// Resolving mirrors looks up sources by name, so it is only done once per frame.
+	_input = resolve_input(obs_filter_get_parent(_self), obs_filter_get_target(_self));
+
 	_source_rendered = false;
 	_output_rendered = false;
 }
 
-void filter::blur::blur_instance::video_render(gs_effect_t* effect)
+void filter::blur::blur_instance::video_render(gs_effect_t*)
 {
 	obs_source_t* parent        = obs_filter_get_parent(this->_self);
 	obs_source_t* target        = obs_filter_get_target(this->_self);
@@ -859,8 +1074,7 @@ void filter::blur::blur_instance::video_render(gs_effect_t* effect)
 	uint32_t      baseW         = obs_source_get_base_width(target);
 	uint32_t      baseH         = obs_source_get_base_height(target);
 
-	std::shared_ptr<gs::effect> colorConversionEffect = blur_factory::get()->get_color_converter_effect();
-	vec4                        black;
+	vec4 black;
 
 	vec4_set(&black, 0, 0, 0, 0);
 
@@ -870,17 +1084,42 @@ void filter::blur::blur_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
-	if (!_source_rendered) {
+	// With a size map, the mask scales the size of the blur per pixel instead of mixing the original and the blurred
+	//  image. Only some blurs support this, the others fall back to mixing.
+	auto size_map_blur = std::dynamic_pointer_cast<::gfx::blur::base_size_map>(_blur);
+	bool size_mapped   = _mask.enabled && (_mask.mode == mask_mode::Size) && size_map_blur;
+
+	// Identical blurs of the same input in the same frame are only rendered once, and then shared between all
+	//  instances of this filter.
+	blur_cache_key_t cache_key   = get_cache_key(_input ? _input : target);
+	uint64_t         cache_frame = obs_get_video_frame_time();
+	bool             cached      = false;
+	if (!_output_rendered && !size_mapped) {
+		_output_texture = blur_factory::get()->get_cached_blur(cache_key, cache_frame);
+		cached          = (_output_texture != nullptr);
+	}
+
+	if (!_source_rendered && (_mask.enabled || !cached)) {
+		// Without a mask nothing needs the original at full resolution, so the first reduction step can be done
+		//  while capturing the source.
+		_source_divisor = (!_mask.enabled && (_blur_resolution > 1)) ? 2 : 1;
+		uint32_t width  = std::max(baseW / _source_divisor, 1u);
+		uint32_t height = std::max(baseH / _source_divisor, 1u);
+
 		// Source To Texture
 		{
 			if (obs_source_process_filter_begin(this->_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
 				{
-					auto op = this->_source_rt->render(baseW, baseH);
+					auto op = this->_source_rt->render(width, height);
 
+					// Premultiply the alpha while capturing, so that the blurs never mix the color of fully
+					//  transparent pixels into the visible ones. The source may draw more than once, which is why
+					//  this is a regular blend onto a cleared target instead of a replacement.
 					gs_blend_state_push();
 					gs_reset_blend_state();
-					gs_enable_blending(false);
-					gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+					gs_enable_blending(true);
+					gs_blend_function_separate(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA, GS_BLEND_ONE,
+											   GS_BLEND_INVSRCALPHA);
 
 					gs_set_cull_mode(GS_NEITHER);
 					gs_enable_color(true, true, true, true);
@@ -895,7 +1134,7 @@ void filter::blur::blur_instance::video_render(gs_effect_t* effect)
 
 					// Orthographic Camera and clear RenderTarget.
 					gs_ortho(0, (float)baseW, 0, (float)baseH, -1., 1.);
-					//gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &black, 0, 0);
+					gs_clear(GS_CLEAR_COLOR, &black, 0, 0);
 
 					// Render
 					obs_source_process_filter_end(this->_self, defaultEffect, baseW, baseH);
@@ -918,95 +1157,111 @@ void filter::blur::blur_instance::video_render(gs_effect_t* effect)
 	}
 
 	if (!_output_rendered) {
-		_blur->set_input(_source_texture);
-		_output_texture = _blur->render();
+		// Mask Source
+		if (_mask.enabled && _mask.source.source_texture) {
+			uint32_t source_width  = obs_source_get_width(this->_mask.source.source_texture->get_object());
+			uint32_t source_height = obs_source_get_height(this->_mask.source.source_texture->get_object());
 
-		// Mask
-		if (_mask.enabled) {
-			gs_blend_state_push();
-			gs_reset_blend_state();
-			gs_enable_color(true, true, true, true);
-			gs_enable_blending(false);
-			gs_enable_depth_test(false);
-			gs_enable_stencil_test(false);
-			gs_enable_stencil_write(false);
-			gs_set_cull_mode(GS_NEITHER);
-			gs_depth_function(GS_ALWAYS);
-			gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
-			gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
-			gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
-
-			std::string technique = "";
-			switch (this->_mask.type) {
-			case Region:
-				if (this->_mask.region.feather > std::numeric_limits<float_t>::epsilon()) {
-					if (this->_mask.region.invert) {
-						technique = "RegionFeatherInverted";
-					} else {
-						technique = "RegionFeather";
-					}
-				} else {
-					if (this->_mask.region.invert) {
-						technique = "RegionInverted";
-					} else {
-						technique = "Region";
-					}
+			if (source_width == 0) {
+				source_width = baseW;
+			}
+			if (source_height == 0) {
+				source_height = baseH;
+			}
+			if (this->_mask.source.is_scene) {
+				obs_video_info ovi;
+				if (obs_get_video_info(&ovi)) {
+					source_width  = ovi.base_width;
+					source_height = ovi.base_height;
 				}
-				break;
-			case Image:
-			case Source:
-				technique = "Image";
-				break;
 			}
 
-			if (_mask.source.source_texture) {
-				uint32_t source_width  = obs_source_get_width(this->_mask.source.source_texture->get_object());
-				uint32_t source_height = obs_source_get_height(this->_mask.source.source_texture->get_object());
+			this->_mask.source.texture = this->_mask.source.source_texture->render(source_width, source_height);
+		}
+	}
+
+	if (!_output_rendered && !cached) {
+		if (size_map_blur) {
+			size_map_blur->set_size_map(size_mapped ? render_size_map(baseW, baseH) : nullptr);
+		}
 
-				if (source_width == 0) {
-					source_width = baseW;
-				}
-				if (source_height == 0) {
-					source_height = baseH;
-				}
-				if (this->_mask.source.is_scene) {
-					obs_video_info ovi;
-					if (obs_get_video_info(&ovi)) {
-						source_width  = ovi.base_width;
-						source_height = ovi.base_height;
+		// Reuse the previous result if neither the input nor any of the parameters changed since then. The size map
+		//  may change on its own, so results that depend on it are never reused. The probes are read back one frame
+		//  late to avoid stalling, so a change of the input shows up one frame after it happened. They also only
+		//  compare block averages of the input, so changes that keep every average the same are missed.
+		bool changed = size_mapped || !_probe || _probe->probe(_source_texture);
+		if (!changed && _reuse_texture && (_reuse_blur == _blur) && _reuse_key && (*_reuse_key == cache_key)
+			&& _probe->matches_mark()) {
+			_output_texture = _reuse_texture;
+		} else {
+			// Reduce the resolution in steps of two, so that every step is an exact 2x2 average.
+			std::shared_ptr<gs::texture> blur_input = _source_texture;
+			if (_blur_resolution > _source_divisor) {
+				gs_blend_state_push();
+				gs_reset_blend_state();
+				gs_enable_color(true, true, true, true);
+				gs_enable_blending(false);
+				gs_enable_depth_test(false);
+				gs_enable_stencil_test(false);
+				gs_enable_stencil_write(false);
+				gs_set_cull_mode(GS_NEITHER);
+				gs_depth_function(GS_ALWAYS);
+				gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+				gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+				gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+				gs_eparam_t* param = gs_effect_get_param_by_name(defaultEffect, "image");
+				for (size_t n = 0, divisor = 2; divisor <= _blur_resolution; n++, divisor *= 2) {
+					if (divisor <= _source_divisor) {
+						continue;
 					}
-				}
 
-				this->_mask.source.texture = this->_mask.source.source_texture->render(source_width, source_height);
-			}
+					uint32_t width  = std::max(baseW / uint32_t(divisor), 1u);
+					uint32_t height = std::max(baseH / uint32_t(divisor), 1u);
 
-			std::shared_ptr<gs::effect> mask_effect = blur_factory::get()->get_mask_effect();
-			apply_mask_parameters(mask_effect, _source_texture->get_object(), _output_texture->get_object());
-
-			try {
-				auto op = this->_output_rt->render(baseW, baseH);
-				gs_ortho(0, (float)baseW, 0, (float)baseH, -1, 1);
+					gs_effect_set_texture(param, blur_input->get_object());
+					{
+						auto op = this->_scaled_rt[n]->render(width, height);
+						gs_ortho(0, (float)width, 0, (float)height, -1, 1);
+						while (gs_effect_loop(defaultEffect, "Draw")) {
+							gs_draw_sprite(blur_input->get_object(), 0, width, height);
+						}
+					}
 
-				// Render
-				while (gs_effect_loop(mask_effect->get_object(), technique.c_str())) {
-					gs_draw_sprite(_output_texture->get_object(), 0, baseW, baseH);
+					blur_input = this->_scaled_rt[n]->get_texture();
 				}
-			} catch (const std::exception&) {
+
 				gs_blend_state_pop();
-				obs_source_skip_video_filter(this->_self);
-				return;
 			}
-			gs_blend_state_pop();
 
-			if (!(_output_texture = this->_output_rt->get_texture())) {
+			// The blurred result may be smaller than the source, which is undone by the filtered draw below.
+			_blur->set_input(blur_input);
+			_output_texture = _blur->render();
+			if (!_output_texture) {
 				obs_source_skip_video_filter(this->_self);
 				return;
 			}
-		}
 
-		_output_rendered = true;
+			_reuse_blur    = _blur;
+			_reuse_key     = std::make_shared<blur_cache_key_t>(cache_key);
+			_reuse_texture = size_mapped ? nullptr : _output_texture;
+			if (_probe) {
+				_probe->mark();
+			}
+		}
+		if (!size_mapped) {
+			blur_factory::get()->set_cached_blur(cache_key, cache_frame, _blur, _output_texture);
+		}
+	} else if (!_output_rendered) {
+		// Another instance rendered the result, so the probes no longer follow each other.
+		if (_probe) {
+			_probe->reset();
+		}
+		_reuse_texture.reset();
 	}
 
+	_output_rendered = true;
+
 	// Draw source
 	{
 		// It is important that we do not modify the blend state here, as it is set correctly by OBS
@@ -1019,19 +1274,32 @@ void filter::blur::blur_instance::video_render(gs_effect_t* effect)
 		gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 		gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-		gs_effect_t* finalEffect = effect ? effect : defaultEffect;
-		const char*  technique   = "Draw";
+		if (_mask.enabled && !size_mapped) {
+			// Combine original and blurred image straight into the output, instead of an intermediate copy.
+			std::string technique = get_mask_technique();
 
-		gs_eparam_t* param = gs_effect_get_param_by_name(finalEffect, "image");
-		if (!param) {
-			P_LOG_ERROR("<filter-blur:%s> Failed to set image param.", obs_source_get_name(this->_self));
-			obs_source_skip_video_filter(_self);
-			return;
+			std::shared_ptr<gs::effect> mask_effect = blur_factory::get()->get_mask_effect();
+			apply_mask_parameters(mask_effect, _source_texture->get_object(), _output_texture->get_object());
+
+			while (gs_effect_loop(mask_effect->get_object(), technique.c_str())) {
+				gs_draw_sprite(_output_texture->get_object(), 0, baseW, baseH);
+			}
 		} else {
-			gs_effect_set_texture(param, _output_texture->get_object());
-		}
-		while (gs_effect_loop(finalEffect, technique)) {
-			gs_draw_sprite(_output_texture->get_object(), 0, baseW, baseH);
+			// Undo the premultiplication while drawing, as OBS expects straight alpha.
+			gs_effect_t* finalEffect = defaultEffect;
+			const char*  technique   = "DrawAlphaDivide";
+
+			gs_eparam_t* param = gs_effect_get_param_by_name(finalEffect, "image");
+			if (!param) {
+				P_LOG_ERROR("<filter-blur:%s> Failed to set image param.", obs_source_get_name(this->_self));
+				obs_source_skip_video_filter(_self);
+				return;
+			} else {
+				gs_effect_set_texture(param, _output_texture->get_object());
+			}
+			while (gs_effect_loop(finalEffect, technique)) {
+				gs_draw_sprite(_output_texture->get_object(), 0, baseW, baseH);
+			}
 		}
 	}
 }
@@ -18,13 +18,18 @@
  */
 
 #pragma once
+#include <array>
 #include <chrono>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <tuple>
+#include <typeindex>
+#include <vector>
 #include "gfx/blur/gfx-blur-base.hpp"
 #include "gfx/gfx-source-texture.hpp"
+#include "gfx/gfx-texture-probe.hpp"
 #include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-helper.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
@@ -51,14 +56,31 @@ namespace filter {
 			Source,
 		};
 
+		enum mask_mode : int64_t {
+			Mix,
+			Size,
+		};
+
+		// Identifies a blur result by its input and everything that influences it.
+		typedef std::tuple<obs_source_t*, std::type_index, ::gfx::blur::type, double_t, double_t, double_t, double_t,
+						   double_t, double_t, bool, uint32_t>
+			blur_cache_key_t;
+
+		struct blur_cache_entry_t {
+			uint64_t                           frame;
+			std::shared_ptr<::gfx::blur::base> blur;
+			std::shared_ptr<gs::texture>       texture;
+		};
+
 		class blur_factory {
 			obs_source_info             _source_info;
 			std::list<blur_instance*>   _sources;
-			std::shared_ptr<gs::effect> _color_converter_effect;
 			std::shared_ptr<gs::effect> _mask_effect;
 
 			std::map<std::string, std::string> _translation_map;
 
+			std::map<blur_cache_key_t, blur_cache_entry_t> _blur_cache;
+
 			public: // Singleton
 			static void                          initialize();
 			static void                          finalize();
@@ -92,23 +114,39 @@ namespace filter {
 			static void video_render(void* source, gs_effect_t* effect);
 
 			public:
-			std::shared_ptr<gs::effect> get_color_converter_effect();
-
 			std::shared_ptr<gs::effect> get_mask_effect();
+
+			std::shared_ptr<gs::texture> get_cached_blur(blur_cache_key_t const& key, uint64_t frame);
+
+			void set_cached_blur(blur_cache_key_t const& key, uint64_t frame, std::shared_ptr<::gfx::blur::base> blur,
+								 std::shared_ptr<gs::texture> texture);
 		};
 
 		class blur_instance {
 			obs_source_t* _self;
 
 			// Input
+			obs_source_t*                     _input; // Source whose content this filter receives, not referenced.
 			std::shared_ptr<gs::rendertarget> _source_rt;
 			std::shared_ptr<gs::texture>      _source_texture;
 			bool                              _source_rendered;
+			uint32_t                          _source_divisor;
+
+			// Size Map
+			std::shared_ptr<gs::rendertarget> _size_map_rt;
+
+			// Reduced Resolution
+			std::array<std::shared_ptr<gs::rendertarget>, 2> _scaled_rt;
 
 			// Rendering
-			std::shared_ptr<gs::texture>      _output_texture;
-			std::shared_ptr<gs::rendertarget> _output_rt;
-			bool                              _output_rendered;
+			std::shared_ptr<gs::texture> _output_texture;
+			bool                         _output_rendered;
+
+			// Temporal Reuse
+			std::shared_ptr<gfx::texture_probe> _probe;
+			std::shared_ptr<::gfx::blur::base>  _reuse_blur;
+			std::shared_ptr<blur_cache_key_t>   _reuse_key;
+			std::shared_ptr<gs::texture>        _reuse_texture;
 
 			// Blur
 			std::shared_ptr<::gfx::blur::base> _blur;
@@ -117,10 +155,13 @@ namespace filter {
 			std::pair<double_t, double_t>       _blur_center;
 			bool                                _blur_step_scaling;
 			std::pair<double_t, double_t>       _blur_step_scale;
+			bool                                _blur_multipass;
+			uint32_t                            _blur_resolution;
 
 			// Masking
 			struct {
 				bool      enabled;
+				mask_mode mode;
 				mask_type type;
 				struct {
 					float_t left;
@@ -165,6 +206,12 @@ namespace filter {
 
 			void translate_old_settings(obs_data_t*);
 
+			blur_cache_key_t get_cache_key(obs_source_t* input);
+
+			std::string get_mask_technique();
+
+			std::shared_ptr<gs::texture> render_size_map(uint32_t width, uint32_t height);
+
 			public:
 			obs_properties_t* get_properties();
 			void              update(obs_data_t*);
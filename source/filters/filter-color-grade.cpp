@@ -18,6 +18,7 @@
  */
 
 #include "filter-color-grade.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include "strings.hpp"
 #include "util-math.hpp"
@@ -53,6 +54,9 @@
 #define ST_TINT_(x, y) ST_TINT "." D_VSTR(x) "." D_VSTR(y)
 #define ST_CORRECTION ST ".Correction"
 #define ST_CORRECTION_(x) ST_CORRECTION "." D_VSTR(x)
+#define ST_LUT ST ".LUT"
+#define ST_LUT_FILE ST_LUT ".File"
+#define ST_LUT_FILE_TYPES ST_LUT_FILE ".Types"
 
 #define RED Red
 #define GREEN Green
@@ -74,6 +78,8 @@
 #define MODE_LOG Log
 #define MODE_LOG10 Log10
 
+#define LUT_SIZE 33 // Entries per channel, larger sizes reduce the interpolation error.
+
 static const char* get_name(void*) noexcept try {
 	return D_TRANSLATE(ST);
 } catch (const std::exception& ex) {
@@ -119,6 +125,7 @@ static void get_defaults(obs_data_t* data) noexcept try {
 	obs_data_set_default_double(data, ST_CORRECTION_(SATURATION), 100.0);
 	obs_data_set_default_double(data, ST_CORRECTION_(LIGHTNESS), 100.0);
 	obs_data_set_default_double(data, ST_CORRECTION_(CONTRAST), 100.0);
+	obs_data_set_default_string(data, ST_LUT_FILE, "");
 } catch (const std::exception& ex) {
 	P_LOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 } catch (...) {
@@ -150,6 +157,7 @@ static bool tool_modified(obs_properties_t* props, obs_property_t* property, obs
 		 }},
 		{ST_CORRECTION,
 		 {ST_CORRECTION_(HUE), ST_CORRECTION_(SATURATION), ST_CORRECTION_(LIGHTNESS), ST_CORRECTION_(CONTRAST)}},
+		{ST_LUT, {ST_LUT_FILE}},
 		{S_ADVANCED,
 		 {
 			 ST_TINT_MODE,
@@ -190,6 +198,7 @@ static obs_properties_t* get_properties(void*) noexcept try {
 		obs_property_list_add_string(p, D_TRANSLATE(ST_OFFSET), ST_OFFSET);
 		obs_property_list_add_string(p, D_TRANSLATE(ST_TINT), ST_TINT);
 		obs_property_list_add_string(p, D_TRANSLATE(ST_CORRECTION), ST_CORRECTION);
+		obs_property_list_add_string(p, D_TRANSLATE(ST_LUT), ST_LUT);
 		obs_property_list_add_string(p, D_TRANSLATE(S_ADVANCED), S_ADVANCED);
 		obs_property_set_modified_callback(p, &tool_modified);
 	}
@@ -291,6 +300,18 @@ static obs_properties_t* get_properties(void*) noexcept try {
 										1000.0, 0.01);
 	}
 
+	{
+		obs_properties_t* grp = pr;
+		if (!util::are_property_groups_broken()) {
+			grp = obs_properties_create();
+			obs_properties_add_group(pr, ST_LUT, D_TRANSLATE(ST_LUT), OBS_GROUP_NORMAL, grp);
+		}
+
+		auto p = obs_properties_add_path(grp, ST_LUT_FILE, D_TRANSLATE(ST_LUT_FILE), OBS_PATH_FILE,
+										 D_TRANSLATE(ST_LUT_FILE_TYPES), nullptr);
+		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_LUT_FILE)));
+	}
+
 	{
 		obs_properties_t* grp = pr;
 		if (!util::are_property_groups_broken()) {
@@ -404,6 +425,9 @@ void filter::color_grade::color_grade_factory::initialize()
 void filter::color_grade::color_grade_factory::finalize()
 {
 	factory_instance.reset();
+
+	// Parsing a LUT runs code of this plugin, so it has to be done before the plugin is unloaded.
+	gfx::cube_lut::wait_for_jobs();
 }
 
 std::shared_ptr<filter::color_grade::color_grade_factory> filter::color_grade::color_grade_factory::get()
@@ -434,10 +458,73 @@ filter::color_grade::color_grade_factory::color_grade_factory()
 
 filter::color_grade::color_grade_factory::~color_grade_factory() {}
 
+std::shared_ptr<filter::color_grade::lut_t> filter::color_grade::color_grade_factory::get_lut(
+	filter::color_grade::lut_key_t const& key, std::shared_ptr<gfx::cube_lut> cube, uint32_t size)
+{
+	std::unique_lock<std::mutex> ulock(_luts_lock);
+
+	// Instances with identical settings share the same LUT, which is only baked once.
+	auto found = _luts.find(key);
+	if (found != _luts.end()) {
+		std::shared_ptr<lut_t> lut = found->second.lock();
+		if (lut && (lut->cube.lock().get() == std::get<1>(key))) {
+			return lut;
+		}
+	}
+
+	for (auto iter = _luts.begin(); iter != _luts.end();) {
+		if (iter->second.expired()) {
+			iter = _luts.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+
+	auto lut   = std::make_shared<lut_t>();
+	lut->rt    = std::make_shared<gs::rendertarget>(GS_RGBA16F, GS_ZS_NONE);
+	lut->size  = size;
+	lut->baked = false;
+	lut->cube  = cube;
+	_luts[key] = lut;
+	return lut;
+}
+
+std::shared_ptr<gfx::cube_lut> filter::color_grade::color_grade_factory::get_cube_lut(std::string const& file)
+{
+	struct stat st;
+	if (os_stat(file.c_str(), &st) != 0) {
+		throw std::runtime_error("File not found.");
+	}
+
+	std::unique_lock<std::mutex> ulock(_cube_luts_lock);
+
+	// Every instance using the same file shares the parsed table and its texture, until the file is modified.
+	cube_lut_key_t key{file, st.st_mtime};
+	auto           found = _cube_luts.find(key);
+	if (found != _cube_luts.end()) {
+		std::shared_ptr<gfx::cube_lut> lut = found->second.lock();
+		if (lut) {
+			return lut;
+		}
+	}
+
+	for (auto iter = _cube_luts.begin(); iter != _cube_luts.end();) {
+		if (iter->second.expired()) {
+			iter = _cube_luts.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+
+	auto lut        = std::make_shared<gfx::cube_lut>(file);
+	_cube_luts[key] = lut;
+	return lut;
+}
+
 filter::color_grade::color_grade_instance::~color_grade_instance() {}
 
 filter::color_grade::color_grade_instance::color_grade_instance(obs_data_t* data, obs_source_t* context)
-	: _active(true), _self(context)
+	: _active(true), _self(context), _lut_updated(false), _grade_updated(false), _direct(true), _render_count(0)
 {
 	update(data);
 
@@ -456,13 +543,6 @@ filter::color_grade::color_grade_instance::color_grade_instance(obs_data_t* data
 			throw std::runtime_error("Missing file color-grade.effect.");
 		}
 	}
-	{
-		_rt_source = std::make_unique<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		{
-			auto op = _rt_source->render(1, 1);
-		}
-		_tex_source = _rt_source->get_texture();
-	}
 	{
 		_rt_grade = std::make_unique<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 		{
@@ -482,6 +562,43 @@ uint32_t filter::color_grade::color_grade_instance::get_height()
 	return 0;
 }
 
+filter::color_grade::lut_key_t filter::color_grade::color_grade_instance::get_lut_key()
+{
+	std::array<float_t, 32> values = {_lift.x,
+									   _lift.y,
+									   _lift.z,
+									   _lift.w,
+									   _gamma.x,
+									   _gamma.y,
+									   _gamma.z,
+									   _gamma.w,
+									   _gain.x,
+									   _gain.y,
+									   _gain.z,
+									   _gain.w,
+									   _offset.x,
+									   _offset.y,
+									   _offset.z,
+									   _offset.w,
+									   static_cast<float_t>(_tint_detection),
+									   static_cast<float_t>(_tint_luma),
+									   _tint_exponent,
+									   _tint_low.x,
+									   _tint_low.y,
+									   _tint_low.z,
+									   _tint_mid.x,
+									   _tint_mid.y,
+									   _tint_mid.z,
+									   _tint_hig.x,
+									   _tint_hig.y,
+									   _tint_hig.z,
+									   _correction.x,
+									   _correction.y,
+									   _correction.z,
+									   _correction.w};
+	return lut_key_t(values, _cube_lut.get());
+}
+
 float_t fix_gamma_value(double_t v)
 {
 	if (v < 0.0) {
@@ -525,6 +642,25 @@ void filter::color_grade::color_grade_instance::update(obs_data_t* data)
 	_correction.y   = static_cast<float_t>(obs_data_get_double(data, ST_CORRECTION_(SATURATION)) / 100.0);
 	_correction.z   = static_cast<float_t>(obs_data_get_double(data, ST_CORRECTION_(LIGHTNESS)) / 100.0);
 	_correction.w   = static_cast<float_t>(obs_data_get_double(data, ST_CORRECTION_(CONTRAST)) / 100.0);
+
+	// The external LUT is parsed on a background thread, and only replaces the current one in video_tick() once it
+	//  is ready, as update() may run on the graphics thread.
+	{
+		std::string file = obs_data_get_string(data, ST_LUT_FILE);
+		_cube_lut_pending.reset();
+		if (file.length() > 0) {
+			try {
+				_cube_lut_pending = color_grade_factory::get()->get_cube_lut(file);
+			} catch (const std::exception& ex) {
+				P_LOG_ERROR("<filter-color-grade> Loading LUT '%s' failed with error(s): %s", file.c_str(), ex.what());
+				_cube_lut.reset();
+			}
+		} else {
+			_cube_lut.reset();
+		}
+	}
+
+	_lut_updated = false;
 }
 
 void filter::color_grade::color_grade_instance::activate()
@@ -539,8 +675,21 @@ void filter::color_grade::color_grade_instance::deactivate()
 
 void filter::color_grade::color_grade_instance::video_tick(float)
 {
-	_source_updated = false;
-	_grade_updated  = false;
+	// Keep the graded result for the rest of the frame only if the filter was drawn more than once last frame,
+	//  otherwise grade the source while drawing it.
+	_direct        = (_render_count <= 1);
+	_render_count  = 0;
+	_grade_updated = false;
+
+	// Swap in the external LUT once it has been parsed, and drop it if parsing failed.
+	if (_cube_lut_pending) {
+		bool ready = _cube_lut_pending->is_ready();
+		if (ready || _cube_lut_pending->has_failed()) {
+			_cube_lut = ready ? _cube_lut_pending : nullptr;
+			_cube_lut_pending.reset();
+			_lut_updated = false;
+		}
+	}
 }
 
 void filter::color_grade::color_grade_instance::video_render(gs_effect_t*)
@@ -558,28 +707,95 @@ void filter::color_grade::color_grade_instance::video_render(gs_effect_t*)
 		return;
 	}
 
-	if (!_source_updated) {
-		if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
-			auto op = _rt_source->render(width, height);
-			gs_blend_state_push();
-			gs_reset_blend_state();
-			gs_set_cull_mode(GS_NEITHER);
-			gs_enable_color(true, true, true, true);
-			gs_enable_blending(false);
-			gs_enable_depth_test(false);
-			gs_enable_stencil_test(false);
-			gs_enable_stencil_write(false);
-			gs_ortho(0, static_cast<float_t>(width), 0, static_cast<float_t>(height), -1., 1.);
-			obs_source_process_filter_end(_self, effect_default, width, height);
-			gs_blend_state_pop();
+	_render_count++;
+
+	if (!_lut_updated) {
+		// Bake at least at the resolution of the external LUT, so that as little detail as possible is lost.
+		uint32_t size = LUT_SIZE;
+		if (_cube_lut && _cube_lut->is_3d()) {
+			size = std::max(size, _cube_lut->get_size());
 		}
 
-		_tex_source     = _rt_source->get_texture();
-		_source_updated = true;
+		_lut         = color_grade_factory::get()->get_lut(get_lut_key(), _cube_lut, size);
+		_lut_updated = true;
+	}
+
+	if (!_lut->baked) {
+		// The grade is a pure function of the color, so it only has to be evaluated once per LUT entry.
+		auto op = _lut->rt->render(_lut->size * _lut->size, _lut->size);
+		gs_blend_state_push();
+		gs_reset_blend_state();
+		gs_set_cull_mode(GS_NEITHER);
+		gs_enable_color(true, true, true, true);
+		gs_enable_blending(false);
+		gs_enable_depth_test(false);
+		gs_enable_stencil_test(false);
+		gs_enable_stencil_write(false);
+		gs_ortho(0., 1., 0., 1., -1., 1.);
+
+		if (_effect->has_parameter("pLUTSize"))
+			_effect->get_parameter("pLUTSize")->set_float(float_t(_lut->size));
+		if (_effect->has_parameter("pLift"))
+			_effect->get_parameter("pLift")->set_float4(_lift);
+		if (_effect->has_parameter("pGamma"))
+			_effect->get_parameter("pGamma")->set_float4(_gamma);
+		if (_effect->has_parameter("pGain"))
+			_effect->get_parameter("pGain")->set_float4(_gain);
+		if (_effect->has_parameter("pOffset"))
+			_effect->get_parameter("pOffset")->set_float4(_offset);
+		if (_effect->has_parameter("pTintDetection"))
+			_effect->get_parameter("pTintDetection")->set_int(static_cast<int32_t>(_tint_detection));
+		if (_effect->has_parameter("pTintMode"))
+			_effect->get_parameter("pTintMode")->set_int(static_cast<int32_t>(_tint_luma));
+		if (_effect->has_parameter("pTintExponent"))
+			_effect->get_parameter("pTintExponent")->set_float(_tint_exponent);
+		if (_effect->has_parameter("pTintLow"))
+			_effect->get_parameter("pTintLow")->set_float3(_tint_low);
+		if (_effect->has_parameter("pTintMid"))
+			_effect->get_parameter("pTintMid")->set_float3(_tint_mid);
+		if (_effect->has_parameter("pTintHig"))
+			_effect->get_parameter("pTintHig")->set_float3(_tint_hig);
+		if (_effect->has_parameter("pCorrection"))
+			_effect->get_parameter("pCorrection")->set_float4(_correction);
+		if (_effect->has_parameter("pCubeMode"))
+			_effect->get_parameter("pCubeMode")->set_int(_cube_lut ? (_cube_lut->is_3d() ? 2 : 1) : 0);
+		if (_cube_lut) {
+			if (_effect->has_parameter("pCube"))
+				_effect->get_parameter("pCube")->set_texture(_cube_lut->get_texture());
+			if (_effect->has_parameter("pCubeSize"))
+				_effect->get_parameter("pCubeSize")->set_float(float_t(_cube_lut->get_size()));
+			if (_effect->has_parameter("pCubeDomainMin"))
+				_effect->get_parameter("pCubeDomainMin")->set_float3(_cube_lut->get_domain_min());
+			if (_effect->has_parameter("pCubeDomainMax"))
+				_effect->get_parameter("pCubeDomainMax")->set_float3(_cube_lut->get_domain_max());
+		}
+
+		while (gs_effect_loop(_effect->get_object(), "Bake")) {
+			gs_draw_sprite(nullptr, 0, 1, 1);
+		}
+
+		gs_blend_state_pop();
+
+		_lut->baked = true;
+	}
+
+	if (_effect->has_parameter("pLUT"))
+		_effect->get_parameter("pLUT")->set_texture(_lut->rt->get_texture());
+	if (_effect->has_parameter("pLUTSize"))
+		_effect->get_parameter("pLUTSize")->set_float(float_t(_lut->size));
+
+	// The grade is a per-pixel operation, so it is applied while OBS draws the source.
+	if (_direct) {
+		if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
+			obs_source_process_filter_end(_self, _effect->get_object(), width, height);
+		} else {
+			obs_source_skip_video_filter(_self);
+		}
+		return;
 	}
 
 	if (!_grade_updated) {
-		{
+		if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
 			auto op = _rt_grade->render(width, height);
 			gs_blend_state_push();
 			gs_reset_blend_state();
@@ -590,41 +806,16 @@ void filter::color_grade::color_grade_instance::video_render(gs_effect_t*)
 			gs_enable_stencil_test(false);
 			gs_enable_stencil_write(false);
 			gs_ortho(0, static_cast<float_t>(width), 0, static_cast<float_t>(height), -1., 1.);
-
-			if (_effect->has_parameter("image"))
-				_effect->get_parameter("image")->set_texture(_tex_source);
-			if (_effect->has_parameter("pLift"))
-				_effect->get_parameter("pLift")->set_float4(_lift);
-			if (_effect->has_parameter("pGamma"))
-				_effect->get_parameter("pGamma")->set_float4(_gamma);
-			if (_effect->has_parameter("pGain"))
-				_effect->get_parameter("pGain")->set_float4(_gain);
-			if (_effect->has_parameter("pOffset"))
-				_effect->get_parameter("pOffset")->set_float4(_offset);
-			if (_effect->has_parameter("pTintDetection"))
-				_effect->get_parameter("pTintDetection")->set_int(static_cast<int32_t>(_tint_detection));
-			if (_effect->has_parameter("pTintMode"))
-				_effect->get_parameter("pTintMode")->set_int(static_cast<int32_t>(_tint_luma));
-			if (_effect->has_parameter("pTintExponent"))
-				_effect->get_parameter("pTintExponent")->set_float(_tint_exponent);
-			if (_effect->has_parameter("pTintLow"))
-				_effect->get_parameter("pTintLow")->set_float3(_tint_low);
-			if (_effect->has_parameter("pTintMid"))
-				_effect->get_parameter("pTintMid")->set_float3(_tint_mid);
-			if (_effect->has_parameter("pTintHig"))
-				_effect->get_parameter("pTintHig")->set_float3(_tint_hig);
-			if (_effect->has_parameter("pCorrection"))
-				_effect->get_parameter("pCorrection")->set_float4(_correction);
-
-			while (gs_effect_loop(_effect->get_object(), "Draw")) {
-				gs_draw_sprite(nullptr, 0, width, height);
-			}
-
+			obs_source_process_filter_end(_self, _effect->get_object(), width, height);
 			gs_blend_state_pop();
+		} else {
+			// The previous grade is of older content, so it must not be drawn instead.
+			obs_source_skip_video_filter(_self);
+			return;
 		}
 
-		_tex_grade      = _rt_grade->get_texture();
-		_source_updated = true;
+		_tex_grade     = _rt_grade->get_texture();
+		_grade_updated = true;
 	}
 
 	// Render final result.
@@ -18,8 +18,14 @@
  */
 
 #pragma once
+#include <array>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <vector>
+#include "gfx/gfx-cube-lut.hpp"
 #include "obs/gs/gs-mipmapper.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
@@ -28,9 +34,31 @@
 
 namespace filter {
 	namespace color_grade {
+		// All settings that influence the grade, in the order of the effect parameters, and the external LUT. The
+		//  external LUT is only identified by its address, so that the key does not keep it alive.
+		typedef std::tuple<std::array<float_t, 32>, gfx::cube_lut*> lut_key_t;
+
+		struct lut_t {
+			std::shared_ptr<gs::rendertarget> rt;
+			uint32_t                          size;
+			bool                              baked;
+
+			// External LUT that was baked in, so that a new one at the same address is not mistaken for it.
+			std::weak_ptr<gfx::cube_lut> cube;
+		};
+
+		// External LUTs are identified by their path and modification time.
+		typedef std::tuple<std::string, time_t> cube_lut_key_t;
+
 		class color_grade_factory {
 			obs_source_info sourceInfo;
 
+			std::mutex                                _luts_lock;
+			std::map<lut_key_t, std::weak_ptr<lut_t>> _luts;
+
+			std::mutex                                             _cube_luts_lock;
+			std::map<cube_lut_key_t, std::weak_ptr<gfx::cube_lut>> _cube_luts;
+
 			public: // Singleton
 			static void                                 initialize();
 			static void                                 finalize();
@@ -39,6 +67,10 @@ namespace filter {
 			public:
 			color_grade_factory();
 			~color_grade_factory();
+
+			std::shared_ptr<lut_t> get_lut(lut_key_t const& key, std::shared_ptr<gfx::cube_lut> cube, uint32_t size);
+
+			std::shared_ptr<gfx::cube_lut> get_cube_lut(std::string const& file);
 		};
 
 		enum class detection_mode {
@@ -61,15 +93,20 @@ namespace filter {
 
 			std::shared_ptr<gs::effect> _effect;
 
-			// Source
-			std::unique_ptr<gs::rendertarget> _rt_source;
-			std::shared_ptr<gs::texture>      _tex_source;
-			bool                              _source_updated;
+			// Look-Up Table
+			std::shared_ptr<lut_t> _lut;
+			bool                   _lut_updated;
+
+			// External Look-Up Table
+			std::shared_ptr<gfx::cube_lut> _cube_lut;
+			std::shared_ptr<gfx::cube_lut> _cube_lut_pending;
 
 			// Grading
 			std::unique_ptr<gs::rendertarget> _rt_grade;
 			std::shared_ptr<gs::texture>      _tex_grade;
 			bool                              _grade_updated;
+			bool                              _direct;
+			uint32_t                          _render_count;
 
 			// Parameters
 			vec4           _lift;
@@ -91,6 +128,8 @@ namespace filter {
 			uint32_t get_width();
 			uint32_t get_height();
 
+			lut_key_t get_lut_key();
+
 			void update(obs_data_t*);
 			void activate();
 			void deactivate();
@@ -18,15 +18,181 @@
 */
 
 #include "filter-displacement.hpp"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
 #include <stdexcept>
 #include <sys/stat.h>
+#include <vector>
+#include "obs/gs/gs-helper.hpp"
+#include "obs/obs-source-tracker.hpp"
 #include "strings.hpp"
 
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <graphics/graphics.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
 #define ST "Filter.Displacement"
 #define ST_FILE "Filter.Displacement.File"
 #define ST_FILE_TYPES "Filter.Displacement.File.Types"
 #define ST_RATIO "Filter.Displacement.Ratio"
 #define ST_SCALE "Filter.Displacement.Scale"
+#define ST_TYPE "Filter.Displacement.Type"
+#define ST_TYPE_FILE "Filter.Displacement.Type.File"
+#define ST_TYPE_SOURCE "Filter.Displacement.Type.Source"
+#define ST_SOURCE "Filter.Displacement.Source"
+
+#define CACHE_PATH "cache/displacement"
+#define CACHE_MAGIC 0x4D445345 // 'ESDM'
+#define CACHE_VERSION 1
+#define CACHE_MAX_FILES 16 // Converted maps kept on disk, older ones are removed.
+
+// Removes all but the CACHE_MAX_FILES most recently written converted maps, so that the cache does not keep growing
+//  with every map that was ever used.
+static void prune_displacement_cache(std::string const& path)
+{
+	std::vector<std::pair<time_t, std::string>> files;
+	if (os_dir_t* dir = os_opendir(path.c_str()); dir != nullptr) {
+		for (os_dirent* entry = os_readdir(dir); entry; entry = os_readdir(dir)) {
+			std::string name = entry->d_name;
+			if (entry->directory || (name.length() < 4) || (name.compare(name.length() - 4, 4, ".bin") != 0)) {
+				continue;
+			}
+
+			std::string file = path + "/" + name;
+			struct stat st;
+			if (os_stat(file.c_str(), &st) == 0) {
+				files.emplace_back(st.st_mtime, file);
+			}
+		}
+		os_closedir(dir);
+	}
+
+	if (files.size() <= CACHE_MAX_FILES) {
+		return;
+	}
+
+	std::sort(files.begin(), files.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+	for (size_t idx = CACHE_MAX_FILES; idx < files.size(); idx++) {
+		if (os_unlink(files[idx].second.c_str()) != 0) {
+			P_LOG_ERROR("<filter-displacement> Failed to remove cache file '%s'.", files[idx].second.c_str());
+		}
+	}
+}
+
+// Only red and green of a displacement map are used, so they are converted to a two channel texture with half the
+//  size and bandwidth. The converted map is stored in the module's config directory, keyed by a hash of the file
+//  contents, so that later loads of the same image skip decoding it.
+static std::shared_ptr<gs::texture> load_displacement_map(std::string const& file)
+{
+	uint64_t hash = 14695981039346656037ull; // FNV-1a
+	{
+		std::ifstream stream(file, std::ios::binary);
+		if (!stream.good()) {
+			throw std::runtime_error("File not found.");
+		}
+		std::vector<char> buffer(65536);
+		while (stream.read(buffer.data(), std::streamsize(buffer.size())) || (stream.gcount() > 0)) {
+			for (std::streamsize n = 0; n < stream.gcount(); n++) {
+				hash = (hash ^ uint8_t(buffer[size_t(n)])) * 1099511628211ull;
+			}
+		}
+	}
+
+	std::string cache_file;
+	{
+		char name[64];
+		snprintf(name, sizeof(name), CACHE_PATH "/%016" PRIx64 ".bin", hash);
+		char* path = obs_module_config_path(name);
+		if (path) {
+			cache_file = path;
+			bfree(path);
+		}
+	}
+
+	uint32_t             header[4] = {0, 0, 0, 0};
+	std::vector<uint8_t> data;
+	if (!cache_file.empty()) {
+		std::ifstream stream(cache_file, std::ios::binary);
+		if (stream.read(reinterpret_cast<char*>(header), sizeof(header)) && (header[0] == CACHE_MAGIC)
+			&& (header[1] == CACHE_VERSION)) {
+			data.resize(size_t(header[2]) * header[3] * 2);
+			if (!stream.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()))) {
+				data.clear();
+			}
+		}
+	}
+
+	if (data.empty()) {
+		gs_color_format format = GS_UNKNOWN;
+		uint32_t        width = 0, height = 0;
+		uint8_t*        image = gs_create_texture_file_data(file.c_str(), &format, &width, &height);
+
+		size_t r, g;
+		switch (format) {
+		case GS_RGBA:
+			r = 0, g = 1;
+			break;
+		case GS_BGRA:
+		case GS_BGRX:
+			r = 2, g = 1;
+			break;
+		default:
+			// Anything else is rare enough to be loaded as is.
+			bfree(image);
+			return std::make_shared<gs::texture>(file);
+		}
+
+		header[0] = CACHE_MAGIC;
+		header[1] = CACHE_VERSION;
+		header[2] = width;
+		header[3] = height;
+		data.resize(size_t(width) * height * 2);
+		for (size_t idx = 0, end = size_t(width) * height; idx < end; idx++) {
+			data[idx * 2]     = image[idx * 4 + r];
+			data[idx * 2 + 1] = image[idx * 4 + g];
+		}
+		bfree(image);
+
+		if (!cache_file.empty()) {
+			std::string cache_path;
+			if (char* path = obs_module_config_path(CACHE_PATH); path != nullptr) {
+				cache_path = path;
+				os_mkdirs(path);
+				bfree(path);
+			}
+
+			{
+				std::ofstream stream(cache_file, std::ios::binary | std::ios::trunc);
+				stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+				stream.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+				if (!stream.good()) {
+					P_LOG_ERROR("<filter-displacement> Failed to write cache file '%s'.", cache_file.c_str());
+				}
+			}
+
+			// The cache only grows when a new map is converted, so this is the only place it has to be pruned.
+			if (!cache_path.empty()) {
+				prune_displacement_cache(cache_path);
+			}
+		}
+	}
+
+	if ((header[2] == 0) || (header[3] == 0)) {
+		throw std::runtime_error("Failed to load texture.");
+	}
+
+	auto           gctx = gs::context();
+	const uint8_t* mip  = data.data();
+	return std::make_shared<gs::texture>(header[2], header[3], GS_R8G8, 1, &mip, gs::texture::flags::None);
+}
 
 static const char* get_name(void*) noexcept try {
 	return D_TRANSLATE(ST);
@@ -58,7 +224,9 @@ static void destroy(void* ptr) noexcept try {
 
 static void get_defaults(obs_data_t* data) noexcept try {
 	char* disp = obs_module_file("filter-displacement/neutral.png");
+	obs_data_set_default_int(data, ST_TYPE, filter::displacement::map_type::File);
 	obs_data_set_default_string(data, ST_FILE, disp);
+	obs_data_set_default_string(data, ST_SOURCE, "");
 	obs_data_set_default_double(data, ST_RATIO, 0);
 	obs_data_set_default_double(data, ST_SCALE, 0);
 	bfree(disp);
@@ -68,15 +236,50 @@ static void get_defaults(obs_data_t* data) noexcept try {
 	P_LOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
 }
 
+static bool modified_type(obs_properties_t* props, obs_property_t*, obs_data_t* settings) noexcept try {
+	auto type = static_cast<filter::displacement::map_type>(obs_data_get_int(settings, ST_TYPE));
+	obs_property_set_visible(obs_properties_get(props, ST_FILE), type == filter::displacement::map_type::File);
+	obs_property_set_visible(obs_properties_get(props, ST_SOURCE), type == filter::displacement::map_type::Source);
+	return true;
+} catch (const std::exception& ex) {
+	P_LOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
+	return false;
+} catch (...) {
+	P_LOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+	return false;
+}
+
 static obs_properties_t* get_properties(void* ptr) noexcept try {
 	obs_properties_t* pr = obs_properties_create();
+	obs_property_t*   p  = nullptr;
 
 	std::string path = "";
 	if (ptr)
 		path = reinterpret_cast<filter::displacement::displacement_instance*>(ptr)->get_file();
 
+	p = obs_properties_add_list(pr, ST_TYPE, D_TRANSLATE(ST_TYPE), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p, D_TRANSLATE(ST_TYPE_FILE), filter::displacement::map_type::File);
+	obs_property_list_add_int(p, D_TRANSLATE(ST_TYPE_SOURCE), filter::displacement::map_type::Source);
+	obs_property_set_modified_callback(p, modified_type);
+
 	obs_properties_add_path(pr, ST_FILE, D_TRANSLATE(ST_FILE), obs_path_type::OBS_PATH_FILE, D_TRANSLATE(ST_FILE_TYPES),
 							path.c_str());
+
+	p = obs_properties_add_list(pr, ST_SOURCE, D_TRANSLATE(ST_SOURCE), OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(p, "", "");
+	obs::source_tracker::get()->enumerate(
+		[&p](std::string name, obs_source_t*) {
+			obs_property_list_add_string(p, std::string(name + " (Source)").c_str(), name.c_str());
+			return false;
+		},
+		obs::source_tracker::filter_video_sources);
+	obs::source_tracker::get()->enumerate(
+		[&p](std::string name, obs_source_t*) {
+			obs_property_list_add_string(p, std::string(name + " (Scene)").c_str(), name.c_str());
+			return false;
+		},
+		obs::source_tracker::filter_scenes);
+
 	obs_properties_add_float_slider(pr, ST_RATIO, D_TRANSLATE(ST_RATIO), 0, 1, 0.01);
 	obs_properties_add_float_slider(pr, ST_SCALE, D_TRANSLATE(ST_SCALE), -1000, 1000, 0.01);
 	return pr;
@@ -186,6 +389,31 @@ filter::displacement::displacement_factory::displacement_factory()
 
 filter::displacement::displacement_factory::~displacement_factory() {}
 
+std::shared_ptr<gs::texture> filter::displacement::displacement_factory::get_capture(obs_source_t* source,
+																					 uint64_t      frame)
+{
+	auto found = _captures.find(source);
+	if ((found == _captures.end()) || (found->second.frame != frame)) {
+		return nullptr;
+	}
+	return found->second.texture;
+}
+
+void filter::displacement::displacement_factory::set_capture(obs_source_t* source, uint64_t frame,
+															 std::shared_ptr<gs::texture> texture)
+{
+	// Captures from older frames can never be hit again.
+	for (auto iter = _captures.begin(); iter != _captures.end();) {
+		if (iter->second.frame != frame) {
+			iter = _captures.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+
+	_captures[source] = {frame, texture};
+}
+
 void filter::displacement::displacement_instance::validate_file_texture(std::string file)
 {
 	bool do_update = false;
@@ -203,7 +431,7 @@ void filter::displacement::displacement_instance::validate_file_texture(std::str
 
 	// Timestamp verification
 	struct stat stats;
-	if (os_stat(_file_name.c_str(), &stats) != 0) {
+	if (os_stat(_file_name.c_str(), &stats) == 0) {
 		do_update           = do_update || (stats.st_ctime != _file_create_time);
 		do_update           = do_update || (stats.st_mtime != _file_modified_time);
 		do_update           = do_update || (static_cast<size_t>(stats.st_size) != _file_size);
@@ -216,15 +444,17 @@ void filter::displacement::displacement_instance::validate_file_texture(std::str
 
 	if (do_update) {
 		try {
-			_file_texture = std::make_shared<gs::texture>(_file_name);
-		} catch (...) {
+			_file_texture = load_displacement_map(_file_name);
+		} catch (const std::exception& ex) {
+			P_LOG_ERROR("<filter-displacement> Loading displacement map '%s' failed with error(s): %s",
+						_file_name.c_str(), ex.what());
 		}
 	}
 }
 
 filter::displacement::displacement_instance::displacement_instance(obs_data_t* data, obs_source_t* context)
-	: _self(context), _timer(), _effect(), _distance(), _displacement_scale(), _file_create_time(),
-	  _file_modified_time(), _file_size()
+	: _self(context), _timer(), _effect(), _distance(), _displacement_scale(), _map_type(map_type::File),
+	  _file_create_time(), _file_modified_time(), _file_size()
 {
 	char* effectFile = obs_module_file("effects/displace.effect");
 	if (effectFile) {
@@ -243,11 +473,16 @@ filter::displacement::displacement_instance::~displacement_instance()
 {
 	_effect.reset();
 	_file_texture.reset();
+	_source_capture.reset();
 }
 
 void filter::displacement::displacement_instance::update(obs_data_t* data)
 {
-	validate_file_texture(obs_data_get_string(data, ST_FILE));
+	_map_type    = static_cast<map_type>(obs_data_get_int(data, ST_TYPE));
+	_source_name = obs_data_get_string(data, ST_SOURCE);
+	if (_map_type == map_type::File) {
+		validate_file_texture(obs_data_get_string(data, ST_FILE));
+	}
 
 	_distance = float_t(obs_data_get_double(data, ST_RATIO));
 	vec2_set(&_displacement_scale, float_t(obs_data_get_double(data, ST_SCALE)),
@@ -274,6 +509,34 @@ void filter::displacement::displacement_instance::hide() {}
 
 void filter::displacement::displacement_instance::video_tick(float time)
 {
+	if (_map_type == map_type::Source) {
+		// The source may not exist yet, for example while a scene collection is loading, so a failed capture is
+		//  retried once per second. Only the first failure is logged.
+		_timer += time;
+		bool renamed = (_source_name_old != _source_name);
+		bool retry   = !_source_capture && !_source_name.empty() && (_timer >= 1.0f);
+		if (renamed || retry) {
+			_timer = 0;
+			_source_capture.reset();
+			_source_name_old = _source_name;
+			if (!_source_name.empty()) {
+				try {
+					_source_capture = std::make_shared<gfx::source_texture>(_source_name, _self);
+				} catch (...) {
+					if (renamed) {
+						P_LOG_ERROR("<filter-displacement> Instance '%s' failed to grab source '%s'.",
+									obs_source_get_name(_self), _source_name.c_str());
+					}
+				}
+			}
+		}
+		return;
+	}
+
+	// A capture keeps its source active as a child of this filter, so it is released as soon as it is unused.
+	_source_capture.reset();
+	_source_name_old.clear();
+
 	_timer += time;
 	if (_timer >= 1.0f) {
 		_timer -= 1.0f;
@@ -293,7 +556,29 @@ void filter::displacement::displacement_instance::video_render(gs_effect_t*)
 	uint32_t      baseW = obs_source_get_base_width(target), baseH = obs_source_get_base_height(target);
 
 	// Skip rendering if our target, parent or context is not valid.
-	if (!parent || !target || !baseW || !baseH || !_file_texture) {
+	if (!parent || !target || !baseW || !baseH) {
+		obs_source_skip_video_filter(_self);
+		return;
+	}
+
+	std::shared_ptr<gs::texture> displacement_map = _file_texture;
+	if (_map_type == map_type::Source) {
+		displacement_map.reset();
+
+		// All instances using the same source share a single capture of it per frame.
+		obs_source_t* source = _source_capture ? _source_capture->get_object() : nullptr;
+		uint32_t      width  = source ? obs_source_get_width(source) : 0;
+		uint32_t      height = source ? obs_source_get_height(source) : 0;
+		if (source && width && height) {
+			uint64_t frame   = obs_get_video_frame_time();
+			displacement_map = displacement_factory::get()->get_capture(source, frame);
+			if (!displacement_map) {
+				displacement_map = _source_capture->render(width, height);
+				displacement_factory::get()->set_capture(source, frame, displacement_map);
+			}
+		}
+	}
+	if (!displacement_map) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
@@ -311,7 +596,7 @@ void filter::displacement::displacement_instance::video_render(gs_effect_t*)
 		_effect->get_parameter("displacementScale")->set_float2(_displacement_scale);
 	}
 	if (_effect->has_parameter("displacementMap")) {
-		_effect->get_parameter("displacementMap")->set_texture(_file_texture);
+		_effect->get_parameter("displacementMap")->set_texture(displacement_map);
 	}
 
 	obs_source_process_filter_end(_self, _effect->get_object(), baseW, baseH);
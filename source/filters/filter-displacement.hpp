@@ -18,8 +18,10 @@
 */
 
 #pragma once
+#include <map>
 #include <memory>
 #include <string>
+#include "gfx/gfx-source-texture.hpp"
 #include "obs/gs/gs-effect.hpp"
 #include "plugin.hpp"
 
@@ -36,9 +38,21 @@
 
 namespace filter {
 	namespace displacement {
+		enum map_type : int64_t {
+			File,
+			Source,
+		};
+
+		struct capture_entry_t {
+			uint64_t                     frame;
+			std::shared_ptr<gs::texture> texture;
+		};
+
 		class displacement_factory {
 			obs_source_info _source_info;
 
+			std::map<obs_source_t*, capture_entry_t> _captures;
+
 			public: // Singleton
 			static void                                  initialize();
 			static void                                  finalize();
@@ -47,6 +61,10 @@ namespace filter {
 			public:
 			displacement_factory();
 			~displacement_factory();
+
+			std::shared_ptr<gs::texture> get_capture(obs_source_t* source, uint64_t frame);
+
+			void set_capture(obs_source_t* source, uint64_t frame, std::shared_ptr<gs::texture> texture);
 		};
 
 		class displacement_instance {
@@ -59,12 +77,18 @@ namespace filter {
 			vec2                        _displacement_scale;
 
 			// Displacement Map
+			map_type                     _map_type;
 			std::string                  _file_name;
 			std::shared_ptr<gs::texture> _file_texture;
 			time_t                       _file_create_time;
 			time_t                       _file_modified_time;
 			size_t                       _file_size;
 
+			// Displacement Source
+			std::string                          _source_name;
+			std::string                          _source_name_old;
+			std::shared_ptr<gfx::source_texture> _source_capture;
+
 			void validate_file_texture(std::string file);
 
 			public:
@@ -18,12 +18,30 @@
  */
 
 #include "filter-sdf-effects.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 #include "strings.hpp"
 
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <util/platform.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
 #define LOG_PREFIX "<filter-sdf-effects> "
 
+#define SDF_MAX_LEVELS 8
+#define SDF_MIN_LEVEL_SIZE 16
+#define SDF_RANGE 4 // Also change this in sdf-producer.effect if modified.
+#define SDF_SETTLE_FRAMES 4 // Frames the input has to stay unchanged before the field is rebuilt from scratch.
+
 // Translation Strings
 #define ST "Filter.SDFEffects"
 
@@ -64,6 +82,7 @@
 
 #define ST_SDF_SCALE "Filter.SDFEffects.SDF.Scale"
 #define ST_SDF_THRESHOLD "Filter.SDFEffects.SDF.Threshold"
+#define ST_SDF_SHARED "Filter.SDFEffects.SDF.Shared"
 
 static std::shared_ptr<filter::sdf_effects::sdf_effects_factory> factory_instance = nullptr;
 
@@ -75,6 +94,9 @@ void filter::sdf_effects::sdf_effects_factory::initialize()
 void filter::sdf_effects::sdf_effects_factory::finalize()
 {
 	factory_instance.reset();
+
+	// Generating a field runs code of this plugin, so it has to be done before the plugin is unloaded.
+	gfx::distance_field::wait_for_jobs();
 }
 
 std::shared_ptr<filter::sdf_effects::sdf_effects_factory> filter::sdf_effects::sdf_effects_factory::get()
@@ -133,6 +155,7 @@ void filter::sdf_effects::sdf_effects_factory::on_list_empty()
 {
 	this->_sdf_producer_effect.reset();
 	this->_sdf_consumer_effect.reset();
+	this->_sdf_cache.clear();
 }
 
 void* filter::sdf_effects::sdf_effects_factory::create(obs_data_t* data, obs_source_t* parent) noexcept try {
@@ -203,6 +226,7 @@ void filter::sdf_effects::sdf_effects_factory::get_defaults(obs_data_t* data) no
 	obs_data_set_default_bool(data, S_ADVANCED, false);
 	obs_data_set_default_double(data, ST_SDF_SCALE, 100.0);
 	obs_data_set_default_double(data, ST_SDF_THRESHOLD, 50.0);
+	obs_data_set_default_bool(data, ST_SDF_SHARED, false);
 } catch (const std::exception& ex) {
 	P_LOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 } catch (...) {
@@ -297,6 +321,32 @@ std::shared_ptr<gs::effect> filter::sdf_effects::sdf_effects_factory::get_sdf_co
 	return this->_sdf_consumer_effect;
 }
 
+bool filter::sdf_effects::sdf_effects_factory::get_cached_sdf(sdf_cache_key_t const& key, uint64_t frame,
+															   sdf_cache_entry_t& entry)
+{
+	auto found = this->_sdf_cache.find(key);
+	if ((found == this->_sdf_cache.end()) || (found->second.frame != frame)) {
+		return false;
+	}
+	entry = found->second;
+	return true;
+}
+
+void filter::sdf_effects::sdf_effects_factory::set_cached_sdf(sdf_cache_key_t const& key,
+															   sdf_cache_entry_t const& entry)
+{
+	// Fields from older frames can never be hit again, and would keep their textures alive.
+	for (auto iter = this->_sdf_cache.begin(); iter != this->_sdf_cache.end();) {
+		if (iter->second.frame != entry.frame) {
+			iter = this->_sdf_cache.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+
+	this->_sdf_cache[key] = entry;
+}
+
 bool filter::sdf_effects::sdf_effects_instance::cb_modified_shadow_inside(void*, obs_properties_t* props, obs_property*,
 																		  obs_data_t* settings) noexcept try {
 	bool v = obs_data_get_bool(settings, ST_SHADOW_INNER);
@@ -378,6 +428,7 @@ bool filter::sdf_effects::sdf_effects_instance::cb_modified_advanced(void*, obs_
 	bool show_advanced = obs_data_get_bool(settings, S_ADVANCED);
 	obs_property_set_visible(obs_properties_get(props, ST_SDF_SCALE), show_advanced);
 	obs_property_set_visible(obs_properties_get(props, ST_SDF_THRESHOLD), show_advanced);
+	obs_property_set_visible(obs_properties_get(props, ST_SDF_SHARED), show_advanced);
 	return true;
 } catch (const std::exception& ex) {
 	P_LOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -385,8 +436,58 @@ bool filter::sdf_effects::sdf_effects_instance::cb_modified_advanced(void*, obs_
 	P_LOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
 }
 
+std::shared_ptr<gfx::distance_field> filter::sdf_effects::sdf_effects_factory::get_distance_field(
+	std::string const& file, uint32_t width, uint32_t height, float_t threshold)
+{
+	struct stat st;
+	if (os_stat(file.c_str(), &st) != 0) {
+		throw std::runtime_error("File not found.");
+	}
+
+	std::unique_lock<std::mutex> ulock(this->_distance_fields_lock);
+
+	// Every instance using the same file with the same settings shares the field, until the file is modified.
+	distance_field_key_t key{file, st.st_mtime, width, height, threshold};
+	auto                 found = this->_distance_fields.find(key);
+	if (found != this->_distance_fields.end()) {
+		std::shared_ptr<gfx::distance_field> field = found->second.lock();
+		if (field) {
+			return field;
+		}
+	}
+
+	for (auto iter = this->_distance_fields.begin(); iter != this->_distance_fields.end();) {
+		if (iter->second.expired()) {
+			iter = this->_distance_fields.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+
+	auto field                  = std::make_shared<gfx::distance_field>(file, width, height, threshold);
+	this->_distance_fields[key] = field;
+	return field;
+}
+
+bool filter::sdf_effects::sdf_effects_instance::find_shared_sdf(obs_source_t* target, sdf_cache_entry_t& entry)
+{
+	// Look for a field published during this frame by any earlier filter in the chain, which has already rendered
+	//  by now as it is part of our input.
+	uint64_t      frame  = obs_get_video_frame_time();
+	obs_source_t* source = target;
+	while (source && (obs_source_get_type(source) == OBS_SOURCE_TYPE_FILTER)) {
+		sdf_cache_key_t key{obs_filter_get_target(source), this->_sdf_scale, this->_sdf_threshold};
+		if (sdf_effects_factory::get()->get_cached_sdf(key, frame, entry)) {
+			return true;
+		}
+		source = obs_filter_get_target(source);
+	}
+	return false;
+}
+
 filter::sdf_effects::sdf_effects_instance::sdf_effects_instance(obs_data_t* settings, obs_source_t* self)
-	: _self(self), _source_rendered(false), _sdf_scale(1.0), _sdf_threshold(), _output_rendered(false),
+	: _self(self), _source_rendered(false), _image_field_timer(0), _sdf_scale(1.0), _sdf_threshold(),
+	  _sdf_shared(false), _sdf_dirty(true), _sdf_stale(false), _sdf_static(0), _sdf_frames(0), _output_rendered(false),
 	  _inner_shadow(false), _inner_shadow_color(), _inner_shadow_range_min(), _inner_shadow_range_max(),
 	  _inner_shadow_offset_x(), _inner_shadow_offset_y(), _outer_shadow(false), _outer_shadow_color(),
 	  _outer_shadow_range_min(), _outer_shadow_range_max(), _outer_shadow_offset_x(), _outer_shadow_offset_y(),
@@ -400,16 +501,21 @@ filter::sdf_effects::sdf_effects_instance::sdf_effects_instance(obs_data_t* sett
 		vec4 transparent = {0};
 
 		this->_source_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		this->_sdf_write = std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
-		this->_sdf_read  = std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
 		this->_output_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 
-		std::shared_ptr<gs::rendertarget> initialize_rts[] = {this->_source_rt, this->_sdf_write, this->_sdf_read,
-															  this->_output_rt};
+		std::vector<std::shared_ptr<gs::rendertarget>> initialize_rts = {this->_source_rt, this->_output_rt};
+		for (size_t n = 0; n < SDF_MAX_LEVELS; n++) {
+			this->_sdf_write.push_back(std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE));
+			this->_sdf_read.push_back(std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE));
+			initialize_rts.push_back(this->_sdf_write.back());
+			initialize_rts.push_back(this->_sdf_read.back());
+		}
 		for (auto rt : initialize_rts) {
 			auto op = rt->render(1, 1);
 			gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &transparent, 0, 0);
 		}
+
+		this->_source_probe = std::make_shared<gfx::texture_probe>();
 	}
 	update(settings);
 }
@@ -538,6 +644,9 @@ obs_properties_t* filter::sdf_effects::sdf_effects_instance::get_properties()
 
 		p = obs_properties_add_float_slider(props, ST_SDF_THRESHOLD, D_TRANSLATE(ST_SDF_THRESHOLD), 0.0, 100.0, 0.01);
 		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_SDF_THRESHOLD)));
+
+		p = obs_properties_add_bool(props, ST_SDF_SHARED, D_TRANSLATE(ST_SDF_SHARED));
+		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_SDF_SHARED)));
 	}
 
 	return props;
@@ -678,6 +787,11 @@ void filter::sdf_effects::sdf_effects_instance::update(obs_data_t* data)
 
 	this->_sdf_scale     = double_t(obs_data_get_double(data, ST_SDF_SCALE) / 100.0);
 	this->_sdf_threshold = float_t(obs_data_get_double(data, ST_SDF_THRESHOLD) / 100.0);
+	this->_sdf_shared    = obs_data_get_bool(data, ST_SDF_SHARED);
+	this->_sdf_dirty     = true;
+
+	// Look up the exact field with the new settings on the next tick.
+	this->_image_field_timer = 1.0f;
 }
 
 uint32_t filter::sdf_effects::sdf_effects_instance::get_width()
@@ -694,7 +808,7 @@ void filter::sdf_effects::sdf_effects_instance::activate() {}
 
 void filter::sdf_effects::sdf_effects_instance::deactivate() {}
 
-void filter::sdf_effects::sdf_effects_instance::video_tick(float)
+void filter::sdf_effects::sdf_effects_instance::video_tick(float delta)
 {
 	uint32_t width  = 1;
 	uint32_t height = 1;
@@ -711,6 +825,43 @@ void filter::sdf_effects::sdf_effects_instance::video_tick(float)
 		height = obs_source_get_height(target);
 	} while (false);
 
+	// Filters directly on an image file use an exact field instead of the one generated on the GPU. Animated
+	//  images are left to the GPU, as only their first frame could be loaded. The file is checked for changes
+	//  once per second, the same as the image source does.
+	do {
+		obs_source_t* parent = obs_filter_get_parent(this->_self);
+		if (!parent || (parent != obs_filter_get_target(this->_self))
+			|| (strcmp(obs_source_get_id(parent), "image_source") != 0)) {
+			this->_image_field.reset();
+			break;
+		}
+
+		this->_image_field_timer += delta;
+		if (this->_image_field && (this->_image_field_timer < 1.0f)) {
+			break;
+		}
+		this->_image_field_timer = 0;
+
+		obs_data_t* settings = obs_source_get_settings(parent);
+		std::string file     = obs_data_get_string(settings, "file");
+		obs_data_release(settings);
+
+		std::string extension = file.substr(std::min(file.find_last_of('.'), file.size()));
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		if (file.empty() || (extension == ".gif")) {
+			this->_image_field.reset();
+			break;
+		}
+
+		try {
+			this->_image_field = sdf_effects_factory::get()->get_distance_field(
+				file, std::max(uint32_t(width * this->_sdf_scale), 1u),
+				std::max(uint32_t(height * this->_sdf_scale), 1u), this->_sdf_threshold);
+		} catch (...) {
+			this->_image_field.reset();
+		}
+	} while (false);
+
 	this->_source_rendered = false;
 	this->_output_rendered = false;
 }
@@ -766,13 +917,36 @@ void filter::sdf_effects::sdf_effects_instance::video_render(gs_effect_t* effect
 				throw std::runtime_error("failed to draw source");
 			}
 
-			// Generate SDF Buffers
-			{
-				this->_sdf_read->get_texture(this->_sdf_texture);
-				if (!this->_sdf_texture) {
-					throw std::runtime_error("SDF Backbuffer empty");
+			// Image files have an exact field computed once on the CPU. Stacked filters can use the field of an
+			//  earlier one, if it was generated with the same settings. This makes them behave like a single filter
+			//  with all of their effects enabled.
+			std::shared_ptr<gs::texture> exact_texture;
+			if (this->_image_field && !this->_image_field->has_failed()) {
+				exact_texture = this->_image_field->get_texture();
+			}
+			sdf_cache_entry_t shared_entry;
+			bool              shared = false;
+			if (exact_texture) {
+				shared_entry = sdf_cache_entry_t{0, exact_texture, this->_source_texture};
+				shared       = true;
+			} else if (this->_sdf_shared) {
+				shared = find_shared_sdf(target, shared_entry);
+			}
+			if (shared) {
+				this->_sdf_texture        = shared_entry.sdf;
+				this->_sdf_source_texture = shared_entry.source;
+
+				// The own field is out of date by the time it is needed again.
+				if (this->_source_probe) {
+					this->_source_probe->reset();
 				}
+				this->_sdf_dirty = true;
+			} else {
+				this->_sdf_source_texture = this->_source_texture;
+			}
 
+			// Generate SDF Buffers
+			if (!shared) {
 				std::shared_ptr<gs::effect> sdf_effect =
 					filter::sdf_effects::sdf_effects_factory::get()->get_sdf_producer_effect();
 				if (!sdf_effect) {
@@ -780,37 +954,100 @@ void filter::sdf_effects::sdf_effects_instance::video_render(gs_effect_t* effect
 				}
 
 				// Scale SDF Size
-				double_t sdfW, sdfH;
-				sdfW = baseW * _sdf_scale;
-				sdfH = baseH * _sdf_scale;
-				if (sdfW <= 1) {
-					sdfW = 1.0;
-				}
-				if (sdfH <= 1) {
-					sdfH = 1.0;
+				uint32_t sdfW = std::max(uint32_t(baseW * _sdf_scale), 1u);
+				uint32_t sdfH = std::max(uint32_t(baseH * _sdf_scale), 1u);
+
+				// Each level only propagates distances by RANGE of its own texels per frame, so far distances are
+				//  resolved by the smaller levels and refined by the larger ones. The finest level ends up with the
+				//  merged field, which is the only one the consumer has to sample.
+				size_t levels = 1;
+				while ((levels < SDF_MAX_LEVELS) && ((sdfW >> levels) >= SDF_MIN_LEVEL_SIZE)
+					   && ((sdfH >> levels) >= SDF_MIN_LEVEL_SIZE)) {
+					levels++;
 				}
 
-				{
-					auto op = this->_sdf_write->render(uint32_t(sdfW), uint32_t(sdfH));
-					gs_ortho(0, (float)sdfW, 0, (float)sdfH, -1, 1);
-					gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
+				// The field only changes while it converges towards the current input, so once it had enough frames to
+				//  do so it is kept until the input or the settings change. While the input changes the old field keeps
+				//  converging, as live content changes every frame. Distances only converge quickly while they shrink,
+				//  so removed content can leave grown distances behind. Once the input settles, all levels restart
+				//  from the furthest distance, of which the first frame only places the edges again.
+				uint32_t coarse  = std::max(sdfW >> (levels - 1), sdfH >> (levels - 1));
+				uint32_t budget  = (coarse + SDF_RANGE - 1) / SDF_RANGE + uint32_t(levels) * 2 + 1;
+				bool     changed = !this->_source_probe || this->_source_probe->probe(this->_source_texture);
+				if (changed) {
+					this->_sdf_stale  = true;
+					this->_sdf_static = 0;
+					this->_sdf_frames = budget;
+				} else if (this->_sdf_stale && (++this->_sdf_static >= SDF_SETTLE_FRAMES)) {
+					this->_sdf_dirty = true;
+				}
+				if (this->_sdf_dirty) {
+					vec4 far;
+					vec4_set(&far, 1.0f, 1.0f, 0.0f, 0.0f);
+					for (size_t level = 0; level < levels; level++) {
+						uint32_t lvlW = std::max(sdfW >> level, 1u);
+						uint32_t lvlH = std::max(sdfH >> level, 1u);
+						auto     op   = this->_sdf_read[level]->render(lvlW, lvlH);
+						gs_ortho(0, (float)lvlW, 0, (float)lvlH, -1, 1);
+						gs_clear(GS_CLEAR_COLOR, &far, 0, 0);
+					}
 
-					sdf_effect->get_parameter("_image")->set_texture(this->_source_texture);
-					sdf_effect->get_parameter("_size")->set_float2(float_t(sdfW), float_t(sdfH));
-					sdf_effect->get_parameter("_sdf")->set_texture(this->_sdf_texture);
-					sdf_effect->get_parameter("_threshold")->set_float(this->_sdf_threshold);
+					this->_sdf_frames = budget;
+					this->_sdf_dirty  = false;
+					this->_sdf_stale  = false;
+					this->_sdf_static = 0;
+				}
 
-					while (gs_effect_loop(sdf_effect->get_object(), "Draw")) {
-						gs_draw_sprite(this->_sdf_texture->get_object(), 0, uint32_t(sdfW), uint32_t(sdfH));
+				if (this->_sdf_frames > 0) {
+					this->_sdf_frames--;
+
+					std::shared_ptr<gs::texture> coarse_texture;
+					for (size_t n = levels; n > 0; n--) {
+						size_t   level = n - 1;
+						uint32_t lvlW  = std::max(sdfW >> level, 1u);
+						uint32_t lvlH  = std::max(sdfH >> level, 1u);
+
+						this->_sdf_read[level]->get_texture(this->_sdf_texture);
+						if (!this->_sdf_texture) {
+							throw std::runtime_error("SDF Backbuffer empty");
+						}
+
+						{
+							auto op = this->_sdf_write[level]->render(lvlW, lvlH);
+							gs_ortho(0, (float)lvlW, 0, (float)lvlH, -1, 1);
+							gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
+
+							sdf_effect->get_parameter("_image")->set_texture(this->_source_texture);
+							sdf_effect->get_parameter("_size")->set_float2(float_t(lvlW), float_t(lvlH));
+							sdf_effect->get_parameter("_sdf")->set_texture(this->_sdf_texture);
+							sdf_effect->get_parameter("_threshold")->set_float(this->_sdf_threshold);
+							if (coarse_texture) {
+								sdf_effect->get_parameter("_sdf_coarse")->set_texture(coarse_texture);
+								sdf_effect->get_parameter("_coarse_scale")
+									->set_float(float_t(lvlW) / float_t(coarse_texture->get_width()));
+							} else {
+								sdf_effect->get_parameter("_sdf_coarse")->set_texture(this->_sdf_texture);
+								sdf_effect->get_parameter("_coarse_scale")->set_float(0.0f);
+							}
+
+							while (gs_effect_loop(sdf_effect->get_object(), "Draw")) {
+								gs_draw_sprite(this->_sdf_texture->get_object(), 0, lvlW, lvlH);
+							}
+						}
+						std::swap(this->_sdf_read[level], this->_sdf_write[level]);
+						this->_sdf_read[level]->get_texture(coarse_texture);
+						if (!coarse_texture) {
+							throw std::runtime_error("SDF Backbuffer empty");
+						}
 					}
-				}
-				std::swap(this->_sdf_read, this->_sdf_write);
-				this->_sdf_read->get_texture(this->_sdf_texture);
-				if (!this->_sdf_texture) {
-					throw std::runtime_error("SDF Backbuffer empty");
+					this->_sdf_texture = coarse_texture;
 				}
 			}
 
+			sdf_effects_factory::get()->set_cached_sdf(
+				sdf_cache_key_t{target, this->_sdf_scale, this->_sdf_threshold},
+				sdf_cache_entry_t{obs_get_video_frame_time(), this->_sdf_texture, this->_sdf_source_texture});
+
 			this->_source_rendered = true;
 		}
 
@@ -865,7 +1102,7 @@ void filter::sdf_effects::sdf_effects_instance::video_render(gs_effect_t* effect
 			if (this->_outer_shadow) {
 				consumer_effect->get_parameter("pSDFTexture")->set_texture(this->_sdf_texture);
 				consumer_effect->get_parameter("pSDFThreshold")->set_float(this->_sdf_threshold);
-				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_source_texture->get_object());
+				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_sdf_source_texture->get_object());
 				consumer_effect->get_parameter("pShadowColor")->set_float4(this->_outer_shadow_color);
 				consumer_effect->get_parameter("pShadowMin")->set_float(this->_outer_shadow_range_min);
 				consumer_effect->get_parameter("pShadowMax")->set_float(this->_outer_shadow_range_max);
@@ -879,7 +1116,7 @@ void filter::sdf_effects::sdf_effects_instance::video_render(gs_effect_t* effect
 			if (this->_inner_shadow) {
 				consumer_effect->get_parameter("pSDFTexture")->set_texture(this->_sdf_texture);
 				consumer_effect->get_parameter("pSDFThreshold")->set_float(this->_sdf_threshold);
-				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_source_texture->get_object());
+				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_sdf_source_texture->get_object());
 				consumer_effect->get_parameter("pShadowColor")->set_float4(this->_inner_shadow_color);
 				consumer_effect->get_parameter("pShadowMin")->set_float(this->_inner_shadow_range_min);
 				consumer_effect->get_parameter("pShadowMax")->set_float(this->_inner_shadow_range_max);
@@ -893,7 +1130,7 @@ void filter::sdf_effects::sdf_effects_instance::video_render(gs_effect_t* effect
 			if (this->_outer_glow) {
 				consumer_effect->get_parameter("pSDFTexture")->set_texture(this->_sdf_texture);
 				consumer_effect->get_parameter("pSDFThreshold")->set_float(this->_sdf_threshold);
-				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_source_texture->get_object());
+				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_sdf_source_texture->get_object());
 				consumer_effect->get_parameter("pGlowColor")->set_float4(this->_outer_glow_color);
 				consumer_effect->get_parameter("pGlowWidth")->set_float(this->_outer_glow_width);
 				consumer_effect->get_parameter("pGlowSharpness")->set_float(this->_outer_glow_sharpness);
@@ -905,7 +1142,7 @@ void filter::sdf_effects::sdf_effects_instance::video_render(gs_effect_t* effect
 			if (this->_inner_glow) {
 				consumer_effect->get_parameter("pSDFTexture")->set_texture(this->_sdf_texture);
 				consumer_effect->get_parameter("pSDFThreshold")->set_float(this->_sdf_threshold);
-				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_source_texture->get_object());
+				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_sdf_source_texture->get_object());
 				consumer_effect->get_parameter("pGlowColor")->set_float4(this->_inner_glow_color);
 				consumer_effect->get_parameter("pGlowWidth")->set_float(this->_inner_glow_width);
 				consumer_effect->get_parameter("pGlowSharpness")->set_float(this->_inner_glow_sharpness);
@@ -917,7 +1154,7 @@ void filter::sdf_effects::sdf_effects_instance::video_render(gs_effect_t* effect
 			if (this->_outline) {
 				consumer_effect->get_parameter("pSDFTexture")->set_texture(this->_sdf_texture);
 				consumer_effect->get_parameter("pSDFThreshold")->set_float(this->_sdf_threshold);
-				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_source_texture->get_object());
+				consumer_effect->get_parameter("pImageTexture")->set_texture(this->_sdf_source_texture->get_object());
 				consumer_effect->get_parameter("pOutlineColor")->set_float4(this->_outline_color);
 				consumer_effect->get_parameter("pOutlineWidth")->set_float(this->_outline_width);
 				consumer_effect->get_parameter("pOutlineOffset")->set_float(this->_outline_offset);
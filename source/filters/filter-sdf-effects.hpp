@@ -18,7 +18,15 @@
  */
 
 #pragma once
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "gfx/gfx-distance-field.hpp"
+#include "gfx/gfx-texture-probe.hpp"
 #include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-sampler.hpp"
@@ -40,6 +48,17 @@ namespace filter {
 	namespace sdf_effects {
 		class sdf_effects_instance;
 
+		// Identifies a distance field by the source it was generated from and everything that influences it.
+		typedef std::tuple<obs_source_t*, double_t, float_t> sdf_cache_key_t;
+
+		typedef std::tuple<std::string, time_t, uint32_t, uint32_t, float_t> distance_field_key_t;
+
+		struct sdf_cache_entry_t {
+			uint64_t                     frame;
+			std::shared_ptr<gs::texture> sdf;
+			std::shared_ptr<gs::texture> source;
+		};
+
 		class sdf_effects_factory {
 			obs_source_info _source_info;
 
@@ -48,6 +67,11 @@ namespace filter {
 			std::shared_ptr<gs::effect> _sdf_producer_effect;
 			std::shared_ptr<gs::effect> _sdf_consumer_effect;
 
+			std::map<sdf_cache_key_t, sdf_cache_entry_t> _sdf_cache;
+
+			std::mutex                                                         _distance_fields_lock;
+			std::map<distance_field_key_t, std::weak_ptr<gfx::distance_field>> _distance_fields;
+
 			public: // Singleton
 			static void                                 initialize();
 			static void                                 finalize();
@@ -80,22 +104,40 @@ namespace filter {
 			public:
 			std::shared_ptr<gs::effect> get_sdf_producer_effect();
 			std::shared_ptr<gs::effect> get_sdf_consumer_effect();
+
+			bool get_cached_sdf(sdf_cache_key_t const& key, uint64_t frame, sdf_cache_entry_t& entry);
+
+			void set_cached_sdf(sdf_cache_key_t const& key, sdf_cache_entry_t const& entry);
+
+			std::shared_ptr<gfx::distance_field> get_distance_field(std::string const& file, uint32_t width,
+																	uint32_t height, float_t threshold);
 		};
 
 		class sdf_effects_instance {
 			obs_source_t* _self;
 
 			// Input
-			std::shared_ptr<gs::rendertarget> _source_rt;
-			std::shared_ptr<gs::texture>      _source_texture;
-			bool                              _source_rendered;
+			std::shared_ptr<gs::rendertarget>   _source_rt;
+			std::shared_ptr<gs::texture>        _source_texture;
+			bool                                _source_rendered;
+			std::shared_ptr<gfx::texture_probe> _source_probe;
+
+			// Exact Distance Field
+			std::shared_ptr<gfx::distance_field> _image_field;
+			float_t                              _image_field_timer;
 
 			// Distance Field
-			std::shared_ptr<gs::rendertarget> _sdf_write;
-			std::shared_ptr<gs::rendertarget> _sdf_read;
-			std::shared_ptr<gs::texture>      _sdf_texture;
-			double_t                          _sdf_scale;
-			float_t                           _sdf_threshold;
+			std::vector<std::shared_ptr<gs::rendertarget>> _sdf_write;
+			std::vector<std::shared_ptr<gs::rendertarget>> _sdf_read;
+			std::shared_ptr<gs::texture>                   _sdf_texture;
+			std::shared_ptr<gs::texture>                   _sdf_source_texture;
+			double_t                                       _sdf_scale;
+			float_t                                        _sdf_threshold;
+			bool                                           _sdf_shared;
+			bool                                           _sdf_dirty;
+			bool                                           _sdf_stale;
+			uint32_t                                       _sdf_static;
+			uint32_t                                       _sdf_frames;
 
 			// Effects
 			bool                              _output_rendered;
@@ -153,6 +195,8 @@ namespace filter {
 			static bool cb_modified_advanced(void* ptr, obs_properties_t* props, obs_property* prop,
 											 obs_data_t* settings) noexcept;
 
+			bool find_shared_sdf(obs_source_t* target, sdf_cache_entry_t& entry);
+
 			public:
 			sdf_effects_instance(obs_data_t* settings, obs_source_t* self);
 			~sdf_effects_instance();
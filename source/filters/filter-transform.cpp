@@ -18,6 +18,8 @@
  */
 
 #include "filter-transform.hpp"
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include "strings.hpp"
 #include "util-math.hpp"
@@ -61,6 +63,12 @@
 #define ST_ROTATION_ORDER_ZXY "Filter.Transform.Rotation.Order.ZXY"
 #define ST_ROTATION_ORDER_ZYX "Filter.Transform.Rotation.Order.ZYX"
 #define ST_MIPMAPPING "Filter.Transform.Mipmapping"
+#define ST_BEND "Filter.Transform.Bend"
+#define ST_BEND_X "Filter.Transform.Bend.X"
+#define ST_BEND_Y "Filter.Transform.Bend.Y"
+#define ST_CURL "Filter.Transform.Curl"
+#define ST_CURL_RADIUS "Filter.Transform.Curl.Radius"
+#define ST_MESH_DENSITY "Filter.Transform.Mesh.Density"
 
 static const float farZ  = 2097152.0f; // 2 pow 21
 static const float nearZ = 1.0f / farZ;
@@ -78,12 +86,13 @@ enum RotationOrder : int64_t {
 
 filter::transform::transform_instance::transform_instance(obs_data_t* data, obs_source_t* context)
 	: obs::source_instance(data, context), _source_rendered(false), _mipmap_enabled(false), _mipmap_strength(50.0),
-	  _mipmap_generator(gs::mipmapper::generator::Linear), _update_mesh(false), _rotation_order(RotationOrder::ZXY),
+	  _mipmap_generator(gs::mipmapper::generator::Linear), _mipmap_minification(1.0f, 1.0f), _mipmap_levels(0),
+	  _update_mesh(false), _mesh_density(32), _mesh_affine(true), _rotation_order(RotationOrder::ZXY), _bend(0, 0),
+	  _curl(0), _curl_radius(0),
 	  _camera_orthographic(true), _camera_fov(90.0)
 {
 	_source_rendertarget = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 	_shape_rendertarget  = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_vertex_buffer       = std::make_shared<gs::vertex_buffer>(uint32_t(4u), uint8_t(1u));
 
 	_position = std::make_unique<util::vec3a>();
 	_rotation = std::make_unique<util::vec3a>();
@@ -103,6 +112,7 @@ filter::transform::transform_instance::~transform_instance()
 	_scale.reset();
 	_rotation.reset();
 	_position.reset();
+	_index_buffer.reset();
 	_vertex_buffer.reset();
 	_shape_texture.reset();
 	_shape_rendertarget.reset();
@@ -131,6 +141,14 @@ void filter::transform::transform_instance::update(obs_data_t* data)
 	_shear->y       = static_cast<float_t>(obs_data_get_double(data, ST_SHEAR_Y) / 100.0);
 	_shear->z       = 0.0f;
 
+	// Deformation
+	_bend.first   = static_cast<float_t>(obs_data_get_double(data, ST_BEND_X) / 180.0 * S_PI);
+	_bend.second  = static_cast<float_t>(obs_data_get_double(data, ST_BEND_Y) / 180.0 * S_PI);
+	_curl         = static_cast<float_t>(obs_data_get_double(data, ST_CURL) / 100.0);
+	_curl_radius  = static_cast<float_t>(obs_data_get_double(data, ST_CURL_RADIUS) / 100.0);
+	_mesh_density = static_cast<uint32_t>(obs_data_get_int(data, ST_MESH_DENSITY));
+	_mesh_affine  = (_bend.first == 0) && (_bend.second == 0) && (_curl == 0);
+
 	// Mipmapping
 	_mipmap_enabled   = obs_data_get_bool(data, ST_MIPMAPPING);
 	_mipmap_strength  = obs_data_get_double(data, S_MIPGENERATOR_INTENSITY);
@@ -218,37 +236,99 @@ void filter::transform::transform_instance::video_tick(float)
 		float_t p_y = 1.0f * _scale->y;
 
 		/// Generate mesh
-		{
-			auto vtx   = _vertex_buffer->at(0);
-			*vtx.color = 0xFFFFFFFF;
-			vec4_set(vtx.uv[0], 0, 0, 0, 0);
-			vec3_set(vtx.position, -p_x + _shear->x, -p_y - _shear->y, 0);
-			vec3_transform(vtx.position, vtx.position, &ident);
-		}
-		{
-			auto vtx   = _vertex_buffer->at(1);
-			*vtx.color = 0xFFFFFFFF;
-			vec4_set(vtx.uv[0], 1, 0, 0, 0);
-			vec3_set(vtx.position, p_x + _shear->x, -p_y + _shear->y, 0);
-			vec3_transform(vtx.position, vtx.position, &ident);
-		}
-		{
-			auto vtx   = _vertex_buffer->at(2);
-			*vtx.color = 0xFFFFFFFF;
-			vec4_set(vtx.uv[0], 0, 1, 0, 0);
-			vec3_set(vtx.position, -p_x - _shear->x, p_y - _shear->y, 0);
-			vec3_transform(vtx.position, vtx.position, &ident);
+		// Without any deformation the mesh is a plain quad, everything else is a grid of density x density cells.
+		uint32_t density = _mesh_affine ? 1 : _mesh_density;
+		uint32_t stride  = density + 1;
+		if (!_vertex_buffer || (_vertex_buffer->size() != (stride * stride))) {
+			_vertex_buffer = std::make_shared<gs::vertex_buffer>(stride * stride, uint8_t(1u));
+			_index_buffer  = std::make_shared<gs::index_buffer>(density * density * 6);
+			for (uint32_t y = 0; y < density; y++) {
+				for (uint32_t x = 0; x < density; x++) {
+					uint32_t idx = x + y * stride;
+					_index_buffer->insert(_index_buffer->end(), {idx, idx + 1, idx + stride});
+					_index_buffer->insert(_index_buffer->end(), {idx + 1, idx + stride + 1, idx + stride});
+				}
+			}
+			_index_buffer->get(true);
 		}
-		{
-			auto vtx   = _vertex_buffer->at(3);
-			*vtx.color = 0xFFFFFFFF;
-			vec4_set(vtx.uv[0], 1, 1, 0, 0);
-			vec3_set(vtx.position, p_x - _shear->x, p_y + _shear->y, 0);
-			vec3_transform(vtx.position, vtx.position, &ident);
+
+		vec3 corner, axis_u, axis_v;
+		vec3_set(&corner, -p_x + _shear->x, -p_y - _shear->y, 0);
+		vec3_set(&axis_u, 2.0f * p_x, 2.0f * _shear->y, 0);
+		vec3_set(&axis_v, -2.0f * _shear->x, 2.0f * p_y, 0);
+
+		// Bends wrap the plane around a cylinder, so that the width (or height) covers the given angle. The curl
+		//  rolls the plane up from the right side, around a cylinder of the given radius.
+		float_t bend_radius_x = (_bend.first != 0) ? (2.0f * p_x / _bend.first) : 0;
+		float_t bend_radius_y = (_bend.second != 0) ? (2.0f * p_y / _bend.second) : 0;
+		float_t curl_line     = p_x - _curl * 2.0f * p_x;
+		float_t curl_radius   = std::max(_curl_radius * 2.0f * p_x, std::numeric_limits<float_t>::epsilon());
+
+		for (uint32_t y = 0; y < stride; y++) {
+			for (uint32_t x = 0; x < stride; x++) {
+				float_t u  = float_t(x) / float_t(density);
+				float_t v  = float_t(y) / float_t(density);
+				float_t lx = (u * 2.0f - 1.0f) * p_x;
+				float_t ly = (v * 2.0f - 1.0f) * p_y;
+
+				auto   vtx = _vertex_buffer->at(x + y * stride);
+				vec3   offset;
+				*vtx.color = 0xFFFFFFFF;
+				vec4_set(vtx.uv[0], u, v, 0, 0);
+				vec3_mulf(vtx.position, &axis_u, u);
+				vec3_mulf(&offset, &axis_v, v);
+				vec3_add(vtx.position, vtx.position, &offset);
+				vec3_add(vtx.position, vtx.position, &corner);
+
+				if (bend_radius_x != 0) {
+					float_t phi = lx / bend_radius_x;
+					vtx.position->x += bend_radius_x * sin(phi) - lx;
+					vtx.position->z += bend_radius_x * (1.0f - cos(phi));
+				}
+				if (bend_radius_y != 0) {
+					float_t phi = ly / bend_radius_y;
+					vtx.position->y += bend_radius_y * sin(phi) - ly;
+					vtx.position->z += bend_radius_y * (1.0f - cos(phi));
+				}
+				if ((_curl > 0) && (lx > curl_line)) {
+					float_t phi = (lx - curl_line) / curl_radius;
+					if (phi < S_PI) {
+						vtx.position->x += curl_line + curl_radius * sin(phi) - lx;
+						vtx.position->z -= curl_radius * (1.0f - cos(phi));
+					} else {
+						vtx.position->x += curl_line - (lx - curl_line - float_t(S_PI) * curl_radius) - lx;
+						vtx.position->z -= 2.0f * curl_radius;
+					}
+				}
+
+				vec3_transform(vtx.position, vtx.position, &ident);
+			}
 		}
 
 		_vertex_buffer->update(true);
 		_update_mesh = false;
+
+		// Find how much the source is shrunk on screen along each axis, which decides how many mip levels are
+		//  actually sampled. Perspective shrinks the far side more, so the shortest edge is used.
+		{
+			uint32_t corners[4] = {0, density, density * stride, stride * stride - 1};
+			vec3     projected[4];
+			float_t  tan_fov = float_t(tan(_camera_fov / 360.0 * S_PI));
+			for (size_t n = 0; n < 4; n++) {
+				vec3 pos = *_vertex_buffer->at(corners[n]).position;
+				if (!_camera_orthographic) {
+					float_t distance = std::max(pos.z + 1.0f, nearZ);
+					pos.x /= distance * tan_fov * aspectRatioX;
+					pos.y /= distance * tan_fov;
+				}
+				vec3_set(&projected[n], pos.x * width / 2.0f, pos.y * height / 2.0f, 0);
+			}
+
+			float_t edge_x = std::min(vec3_dist(&projected[0], &projected[1]), vec3_dist(&projected[2], &projected[3]));
+			float_t edge_y = std::min(vec3_dist(&projected[0], &projected[2]), vec3_dist(&projected[1], &projected[3]));
+			_mipmap_minification.first  = float_t(width) / std::max(edge_x, 1.0f);
+			_mipmap_minification.second = float_t(height) / std::max(edge_y, 1.0f);
+		}
 	}
 
 	this->_source_rendered = false;
@@ -259,7 +339,7 @@ void filter::transform::transform_instance::video_render(gs_effect_t* paramEffec
 	// Grab parent and target.
 	obs_source_t* parent = obs_filter_get_parent(_self);
 	obs_source_t* target = obs_filter_get_target(_self);
-	if (!parent || !target) {
+	if (!parent || !target || !_vertex_buffer) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
@@ -274,6 +354,43 @@ void filter::transform::transform_instance::video_render(gs_effect_t* paramEffec
 
 	gs_effect_t* default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 
+	// Without perspective the mesh is an affine transform of the source, so the source can be drawn directly with
+	//  the transform applied, instead of going through both render targets. The same is true with mipmapping, as
+	//  long as the source is not shrunk. Drawing directly does not clip to the output, so this is only done while
+	//  the whole quad stays inside of it.
+	bool  minified  = (_mipmap_minification.first > 1.0f) || (_mipmap_minification.second > 1.0f);
+	bool  inside    = _mesh_affine && (_vertex_buffer->size() == 4);
+	vec3* positions = _vertex_buffer->get_positions();
+	for (size_t idx = 0; inside && (idx < 4); idx++) {
+		inside = (positions[idx].x >= -1.0f) && (positions[idx].x <= 1.0f) && (positions[idx].y >= -1.0f)
+				 && (positions[idx].y <= 1.0f);
+	}
+	if (_camera_orthographic && inside && !(_mipmap_enabled && minified)) {
+
+		// Map source pixels to the mesh in [-1, 1], and the mesh to the pixels of the output.
+		float_t hw     = float_t(width) / 2.0f;
+		float_t hh     = float_t(height) / 2.0f;
+		float_t aspect = float_t(width) / float_t(height);
+
+		matrix4 affine;
+		vec4_set(&affine.x, (positions[1].x - positions[0].x) / 2.0f,
+				 (positions[1].y - positions[0].y) / 2.0f / aspect, 0, 0);
+		vec4_set(&affine.y, (positions[2].x - positions[0].x) / 2.0f * aspect,
+				 (positions[2].y - positions[0].y) / 2.0f, 0, 0);
+		vec4_set(&affine.z, 0, 0, 1, 0);
+		vec4_set(&affine.t, (positions[0].x + 1.0f) * hw, (positions[0].y + 1.0f) * hh, 0, 1);
+
+		gs_matrix_push();
+		gs_matrix_mul(&affine);
+		if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
+			obs_source_process_filter_end(_self, paramEffect ? paramEffect : default_effect, width, height);
+		} else {
+			obs_source_skip_video_filter(_self);
+		}
+		gs_matrix_pop();
+		return;
+	}
+
 	// Only render if we didn't already render.
 	if (!this->_source_rendered) {
 		std::shared_ptr<gs::texture> source_tex;
@@ -327,23 +444,29 @@ void filter::transform::transform_instance::video_render(gs_effect_t* paramEffec
 		}
 		_source_rendertarget->get_texture(source_tex);
 
-		if (_mipmap_enabled) {
-			if ((!_source_texture) || (_source_texture->get_width() != real_width)
-				|| (_source_texture->get_height() != real_height)) {
-				size_t mip_levels = 0;
-				if (util::math::is_power_of_two(real_width) && util::math::is_power_of_two(real_height)) {
-					size_t w_level = util::math::get_power_of_two_exponent_ceil(real_width);
-					size_t h_level = util::math::get_power_of_two_exponent_ceil(real_height);
-					if (h_level > w_level) {
-						mip_levels = h_level;
-					} else {
-						mip_levels = w_level;
-					}
-				}
+		// Only generate the levels that are sampled at the current minification, plus one to blend towards. Without
+		//  any minification there is nothing to generate, and the source is used as is.
+		size_t mip_levels = 0;
+		if (_mipmap_enabled && util::math::is_power_of_two(real_width) && util::math::is_power_of_two(real_height)) {
+			float_t minification = std::max(_mipmap_minification.first * float_t(real_width) / float_t(width),
+											_mipmap_minification.second * float_t(real_height) / float_t(height));
+			if (minification > 1.0f) {
+				size_t max_levels = size_t(std::max(util::math::get_power_of_two_exponent_ceil(real_width),
+													util::math::get_power_of_two_exponent_ceil(real_height)));
+				mip_levels        = std::min(size_t(ceil(log2(minification))) + 1, max_levels);
+			}
+		}
 
+		if (mip_levels > 0) {
+			// Grow right away, but only shrink once two levels are unused, so that animated transforms do not
+			//  recreate the texture every frame.
+			if ((!_source_texture) || (_source_texture->get_width() != real_width)
+				|| (_source_texture->get_height() != real_height) || (_mipmap_levels < mip_levels)
+				|| (_mipmap_levels > (mip_levels + 1))) {
 				_source_texture =
 					std::make_shared<gs::texture>(real_width, real_height, GS_RGBA, uint32_t(1u + mip_levels), nullptr,
 												  gs::texture::flags::BuildMipMaps);
+				_mipmap_levels = mip_levels;
 			}
 
 			_mipmapper.rebuild(source_tex, _source_texture, _mipmap_generator, float_t(_mipmap_strength));
@@ -375,12 +498,13 @@ void filter::transform::transform_instance::video_render(gs_effect_t* paramEffec
 			gs_enable_stencil_write(false);
 			gs_enable_color(true, true, true, true);
 			gs_load_vertexbuffer(_vertex_buffer->update(false));
-			gs_load_indexbuffer(nullptr);
+			gs_load_indexbuffer(_index_buffer->get(false));
 			while (gs_effect_loop(default_effect, "Draw")) {
 				gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"),
-									  _mipmap_enabled ? _source_texture->get_object() : source_tex->get_object());
-				gs_draw(GS_TRISTRIP, 0, 4);
+									  (mip_levels > 0) ? _source_texture->get_object() : source_tex->get_object());
+				gs_draw(GS_TRIS, 0, uint32_t(_index_buffer->size()));
 			}
+			gs_load_indexbuffer(nullptr);
 			gs_load_vertexbuffer(nullptr);
 		} catch (...) {
 			obs_source_skip_video_filter(_self);
@@ -434,6 +558,11 @@ void filter::transform::transform_factory::get_defaults2(obs_data_t* data)
 	obs_data_set_default_double(data, ST_SCALE_Y, 100);
 	obs_data_set_default_double(data, ST_SHEAR_X, 0);
 	obs_data_set_default_double(data, ST_SHEAR_Y, 0);
+	obs_data_set_default_double(data, ST_BEND_X, 0);
+	obs_data_set_default_double(data, ST_BEND_Y, 0);
+	obs_data_set_default_double(data, ST_CURL, 0);
+	obs_data_set_default_double(data, ST_CURL_RADIUS, 10.0);
+	obs_data_set_default_int(data, ST_MESH_DENSITY, 32);
 	obs_data_set_default_bool(data, S_ADVANCED, false);
 	obs_data_set_default_int(data, ST_ROTATION_ORDER, RotationOrder::ZXY);
 }
@@ -453,6 +582,7 @@ static bool modified_properties(obs_properties_t* pr, obs_property_t*, obs_data_
 	bool advancedVisible = obs_data_get_bool(d, S_ADVANCED);
 	obs_property_set_visible(obs_properties_get(pr, ST_ROTATION_ORDER), advancedVisible);
 	obs_property_set_visible(obs_properties_get(pr, ST_MIPMAPPING), advancedVisible);
+	obs_property_set_visible(obs_properties_get(pr, ST_MESH_DENSITY), advancedVisible);
 
 	bool mipmappingVisible = obs_data_get_bool(d, ST_MIPMAPPING) && advancedVisible;
 	obs_property_set_visible(obs_properties_get(pr, S_MIPGENERATOR), mipmappingVisible);
@@ -529,6 +659,22 @@ obs_properties_t* filter::transform::transform_factory::get_properties2(filter::
 			obs_property_set_long_description(p, D_TRANSLATE(kv.second));
 		}
 	}
+	/// Bend
+	{
+		std::pair<const char*, const char*> entries[] = {
+			std::make_pair(ST_BEND_X, D_DESC(ST_BEND)),
+			std::make_pair(ST_BEND_Y, D_DESC(ST_BEND)),
+		};
+		for (auto kv : entries) {
+			p = obs_properties_add_float_slider(pr, kv.first, D_TRANSLATE(kv.first), -360.0, 360.0, 0.01);
+			obs_property_set_long_description(p, D_TRANSLATE(kv.second));
+		}
+	}
+	/// Curl
+	p = obs_properties_add_float_slider(pr, ST_CURL, D_TRANSLATE(ST_CURL), 0.0, 100.0, 0.01);
+	obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_CURL)));
+	p = obs_properties_add_float_slider(pr, ST_CURL_RADIUS, D_TRANSLATE(ST_CURL_RADIUS), 1.0, 100.0, 0.01);
+	obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_CURL_RADIUS)));
 
 	p = obs_properties_add_bool(pr, S_ADVANCED, D_TRANSLATE(S_ADVANCED));
 	obs_property_set_modified_callback(p, modified_properties);
@@ -547,6 +693,9 @@ obs_properties_t* filter::transform::transform_factory::get_properties2(filter::
 	obs_property_set_modified_callback(p, modified_properties);
 	obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_MIPMAPPING)));
 
+	p = obs_properties_add_int_slider(pr, ST_MESH_DENSITY, D_TRANSLATE(ST_MESH_DENSITY), 1, 128, 1);
+	obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_MESH_DENSITY)));
+
 	p = obs_properties_add_list(pr, S_MIPGENERATOR, D_TRANSLATE(S_MIPGENERATOR), OBS_COMBO_TYPE_LIST,
 								OBS_COMBO_FORMAT_INT);
 	obs_property_set_long_description(p, D_TRANSLATE(D_DESC(S_MIPGENERATOR)));
@@ -20,6 +20,7 @@
 #pragma once
 #include <memory>
 #include <vector>
+#include "obs/gs/gs-indexbuffer.hpp"
 #include "obs/gs/gs-mipmapper.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
@@ -37,10 +38,12 @@ namespace filter {
 			std::pair<uint32_t, uint32_t>     _source_size;
 
 			// Mipmapping
-			bool                     _mipmap_enabled;
-			double_t                 _mipmap_strength;
-			gs::mipmapper::generator _mipmap_generator;
-			gs::mipmapper            _mipmapper;
+			bool                        _mipmap_enabled;
+			double_t                    _mipmap_strength;
+			gs::mipmapper::generator    _mipmap_generator;
+			gs::mipmapper               _mipmapper;
+			std::pair<float_t, float_t> _mipmap_minification;
+			size_t                      _mipmap_levels;
 
 			// Rendering
 			std::shared_ptr<gs::rendertarget> _shape_rendertarget;
@@ -49,12 +52,20 @@ namespace filter {
 			// Mesh
 			bool                               _update_mesh;
 			std::shared_ptr<gs::vertex_buffer> _vertex_buffer;
+			std::shared_ptr<gs::index_buffer>  _index_buffer;
+			uint32_t                           _mesh_density;
+			bool                               _mesh_affine;
 			uint32_t                           _rotation_order;
 			std::unique_ptr<util::vec3a>       _position;
 			std::unique_ptr<util::vec3a>       _rotation;
 			std::unique_ptr<util::vec3a>       _scale;
 			std::unique_ptr<util::vec3a>       _shear;
 
+			// Deformation
+			std::pair<float_t, float_t> _bend;
+			float_t                     _curl;
+			float_t                     _curl_radius;
+
 			// Camera
 			bool    _camera_orthographic;
 			float_t _camera_fov;
@@ -16,7 +16,24 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
 
 #include "gfx-blur-base.hpp"
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs.h>
+#include <util/platform.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// Buckets grow by at most 1.5x, so no more than a third of the samples is ever wasted.
+static const size_t sized_effect_buckets[] = {4, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256};
 
 void gfx::blur::base::set_step_scale_x(double_t v)
 {
@@ -65,3 +82,49 @@ double_t gfx::blur::base_center::get_center_y()
 	this->get_center(x, y);
 	return y;
 }
+
+gfx::blur::sized_effect::sized_effect(std::string file, size_t max_size) : _file(file), _max_size(max_size)
+{
+	char* code = os_quick_read_utf8_file(file.c_str());
+	if (!code) {
+		throw std::runtime_error("Failed to read effect file.");
+	}
+	_code = code;
+	bfree(code);
+}
+
+gfx::blur::sized_effect::~sized_effect()
+{
+	auto gctx = gs::context();
+	_effects.clear();
+}
+
+std::shared_ptr<::gs::effect> gfx::blur::sized_effect::get(double_t size)
+{
+	size_t bucket = _max_size;
+	for (size_t candidate : sized_effect_buckets) {
+		if (double_t(candidate) >= ceil(size)) {
+			bucket = std::min(candidate, _max_size);
+			break;
+		}
+	}
+
+	auto found = _effects.find(bucket);
+	if (found != _effects.end()) {
+		return found->second;
+	}
+
+	// Permutations are compiled on first use, as compiling all of them up front takes several seconds. A failed
+	//  compile is remembered too, so that it is not retried every frame.
+	std::shared_ptr<::gs::effect> effect;
+	try {
+		std::string defines = "#define MAX_BLUR_SIZE " + std::to_string(bucket) + "\n";
+		std::string name    = _file + "?MAX_BLUR_SIZE=" + std::to_string(bucket);
+		auto        gctx    = gs::context();
+		effect              = std::make_shared<::gs::effect>(defines + _code, name);
+	} catch (std::exception& ex) {
+		P_LOG_ERROR("<gfx::blur> Failed to compile '%s' for size %zu: %s", _file.c_str(), bucket, ex.what());
+	}
+	_effects.insert({bucket, effect});
+	return effect;
+}
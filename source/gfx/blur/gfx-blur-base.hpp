@@ -18,7 +18,10 @@
 #pragma once
 #include <cinttypes>
 #include <cmath>
+#include <map>
 #include <memory>
+#include <string>
+#include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-texture.hpp"
 
 namespace gfx {
@@ -35,6 +38,8 @@ namespace gfx {
 			public:
 			virtual ~base() {}
 
+			// Blurs only ever average the input, so they work on premultiplied alpha as-is. Inputs with
+			//  straight alpha should be premultiplied first, otherwise transparent colors bleed into the edges.
 			virtual void set_input(std::shared_ptr<::gs::texture> texture) = 0;
 
 			virtual ::gfx::blur::type get_type() = 0;
@@ -86,6 +91,42 @@ namespace gfx {
 			virtual double_t get_center_y();
 		};
 
+		class base_multipass {
+			public:
+			virtual ~base_multipass() {}
+
+			virtual bool get_multipass() = 0;
+
+			virtual void set_multipass(bool enabled) = 0;
+		};
+
+		class base_size_map {
+			public:
+			virtual ~base_size_map() {}
+
+			// Scales the size per pixel by the red channel of the given texture, or disables this if empty.
+			virtual void set_size_map(std::shared_ptr<::gs::texture> texture) = 0;
+
+			virtual std::shared_ptr<::gs::texture> get_size_map() = 0;
+		};
+
+		// Compiles an effect file once for each bucket of blur sizes, with MAX_BLUR_SIZE defined to the
+		//  upper end of the bucket. The shader loops then have a fixed trip count, which lets the compiler
+		//  unroll them instead of always looping to the absolute maximum and breaking out at runtime. Nothing
+		//  forces it to, as effects have no [unroll] attribute and the GLSL backends decide on their own.
+		class sized_effect {
+			std::string                                     _file;
+			std::string                                     _code;
+			size_t                                          _max_size;
+			std::map<size_t, std::shared_ptr<::gs::effect>> _effects;
+
+			public:
+			sized_effect(std::string file, size_t max_size);
+			virtual ~sized_effect();
+
+			std::shared_ptr<::gs::effect> get(double_t size);
+		};
+
 		class ifactory {
 			public:
 			virtual ~ifactory() {}
@@ -119,6 +160,10 @@ namespace gfx {
 			virtual double_t get_step_step_scale_y(::gfx::blur::type type) = 0;
 
 			virtual double_t get_max_step_scale_y(::gfx::blur::type type) = 0;
+
+			virtual bool is_multipass_supported(::gfx::blur::type type) = 0;
+
+			virtual bool is_size_map_supported(::gfx::blur::type type) = 0;
 		};
 	} // namespace blur
 } // namespace gfx
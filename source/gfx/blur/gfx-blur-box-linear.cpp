@@ -170,6 +170,16 @@ double_t gfx::blur::box_linear_factory::get_max_step_scale_y(::gfx::blur::type)
 	return double_t(1000.0);
 }
 
+bool gfx::blur::box_linear_factory::is_multipass_supported(::gfx::blur::type)
+{
+	return false;
+}
+
+bool gfx::blur::box_linear_factory::is_size_map_supported(::gfx::blur::type)
+{
+	return false;
+}
+
 std::shared_ptr<::gfx::blur::box_linear_data> gfx::blur::box_linear_factory::data()
 {
 	std::unique_lock<std::mutex>                  ulock(_data_lock);
@@ -16,9 +16,11 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
 
 #include "gfx-blur-box.hpp"
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
 #include "util-math.hpp"
@@ -34,13 +36,44 @@
 #endif
 
 #define MAX_BLUR_SIZE 128 // Also change this in box.effect if modified.
+#define MULTIPASS_SIZE 8
+
+// Multi-Pass Box Blur
+//
+// Splits a box of the given size into passes of at most MULTIPASS_SIZE taps per side. Each pass
+//  steps over the full width of all previous passes, so the passes tile into one box again. The
+//  step is then adjusted so that the outermost tap ends up where a single pass would place it.
+//  A box of size 128 takes two passes of 17 taps instead of one pass of 257 taps this way.
+//
+// Returns a list of (size, step multiplier) pairs, one for each pass.
+static std::vector<std::pair<double_t, double_t>> box_multipass_steps(double_t size)
+{
+	std::vector<std::pair<double_t, double_t>> passes;
+	double_t                                   width      = size * 2. + 1.;
+	double_t                                   pass_width = MULTIPASS_SIZE * 2. + 1.;
+	double_t                                   total      = 1.;
+
+	while ((total * pass_width) < width) {
+		passes.emplace_back(double_t(MULTIPASS_SIZE), total);
+		total *= pass_width;
+	}
+	double_t last_size = ceil((width / total - 1.) / 2.);
+	passes.emplace_back(last_size, total);
+	total *= last_size * 2. + 1.;
+
+	double_t adjust = (size * 2.) / (total - 1.);
+	for (auto& pass : passes) {
+		pass.second *= adjust;
+	}
+	return passes;
+}
 
 gfx::blur::box_data::box_data()
 {
 	auto gctx = gs::context();
 	try {
 		char* file = obs_module_file("effects/blur/box.effect");
-		_effect    = std::make_shared<::gs::effect>(file);
+		_effect    = std::make_shared<::gfx::blur::sized_effect>(file, MAX_BLUR_SIZE);
 		bfree(file);
 	} catch (...) {
 		P_LOG_ERROR("<gfx::blur::box> Failed to load _effect.");
@@ -53,9 +86,12 @@ gfx::blur::box_data::~box_data()
 	_effect.reset();
 }
 
-std::shared_ptr<::gs::effect> gfx::blur::box_data::get_effect()
+std::shared_ptr<::gs::effect> gfx::blur::box_data::get_effect(double_t size)
 {
-	return _effect;
+	if (!_effect) {
+		return nullptr;
+	}
+	return _effect->get(size);
 }
 
 gfx::blur::box_factory::box_factory() {}
@@ -178,6 +214,22 @@ double_t gfx::blur::box_factory::get_max_step_scale_y(::gfx::blur::type)
 	return double_t(1000.0);
 }
 
+bool gfx::blur::box_factory::is_multipass_supported(::gfx::blur::type v)
+{
+	switch (v) {
+	case ::gfx::blur::type::Rotational:
+	case ::gfx::blur::type::Zoom:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool gfx::blur::box_factory::is_size_map_supported(::gfx::blur::type)
+{
+	return false;
+}
+
 std::shared_ptr<::gfx::blur::box_data> gfx::blur::box_factory::data()
 {
 	std::unique_lock<std::mutex>           ulock(_data_lock);
@@ -271,7 +323,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box::render()
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
 	// Two Pass Blur
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
+	std::shared_ptr<::gs::effect> effect = _data->get_effect(_size);
 	if (effect) {
 		// Pass 1
 		effect->get_parameter("pImage")->set_texture(_input_texture);
@@ -348,7 +400,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box_directional::render()
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
 	// One Pass Blur
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
+	std::shared_ptr<::gs::effect> effect = _data->get_effect(_size);
 	if (effect) {
 		effect->get_parameter("pImage")->set_texture(_input_texture);
 		effect->get_parameter("pImageTexel")
@@ -371,6 +423,8 @@ std::shared_ptr<::gs::texture> gfx::blur::box_directional::render()
 	return _rendertarget->get_texture();
 }
 
+gfx::blur::box_rotational::box_rotational() : _angle(0), _multipass(false) {}
+
 ::gfx::blur::type gfx::blur::box_rotational::get_type()
 {
 	return ::gfx::blur::type::Rotational;
@@ -398,6 +452,16 @@ void gfx::blur::box_rotational::set_angle(double_t angle)
 	_angle = D_DEG_TO_RAD(angle);
 }
 
+bool gfx::blur::box_rotational::get_multipass()
+{
+	return _multipass;
+}
+
+void gfx::blur::box_rotational::set_multipass(bool enabled)
+{
+	_multipass = enabled;
+}
+
 std::shared_ptr<::gs::texture> gfx::blur::box_rotational::render()
 {
 	auto    gctx   = gs::context();
@@ -417,23 +481,38 @@ std::shared_ptr<::gs::texture> gfx::blur::box_rotational::render()
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	// One Pass Blur
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
+	// One Pass Blur, or Multi-Pass Blur with growing steps.
+	std::shared_ptr<::gs::effect> effect =
+		_data->get_effect(_multipass ? std::min(_size, double_t(MULTIPASS_SIZE)) : _size);
 	if (effect) {
-		effect->get_parameter("pImage")->set_texture(_input_texture);
+		std::vector<std::pair<double_t, double_t>> passes;
+		if (_multipass) {
+			passes = box_multipass_steps(_size);
+		} else {
+			passes.emplace_back(_size, 1.);
+		}
+
 		effect->get_parameter("pImageTexel")->set_float2(float_t(1.f / width), float_t(1.f / height));
 		effect->get_parameter("pStepScale")->set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-		effect->get_parameter("pSize")->set_float(float_t(_size));
-		effect->get_parameter("pSizeInverseMul")->set_float(float_t(1.0f / (float_t(_size) * 2.0f + 1.0f)));
-		effect->get_parameter("pAngle")->set_float(float_t(_angle / _size));
 		effect->get_parameter("pCenter")->set_float2(float_t(_center.first), float_t(_center.second));
 
-		{
-			auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
-			gs_ortho(0, 1., 0, 1., 0, 1.);
-			while (gs_effect_loop(effect->get_object(), "Rotate")) {
-				gs_draw_sprite(nullptr, 0, 1, 1);
+		std::shared_ptr<::gs::texture> tex_cur = _input_texture;
+		for (auto& pass : passes) {
+			effect->get_parameter("pImage")->set_texture(tex_cur);
+			effect->get_parameter("pSize")->set_float(float_t(pass.first));
+			effect->get_parameter("pSizeInverseMul")->set_float(float_t(1.0f / (float_t(pass.first) * 2.0f + 1.0f)));
+			effect->get_parameter("pAngle")->set_float(float_t(_angle / _size * pass.second));
+
+			{
+				auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+				gs_ortho(0, 1., 0, 1., 0, 1.);
+				while (gs_effect_loop(effect->get_object(), "Rotate")) {
+					gs_draw_sprite(nullptr, 0, 1, 1);
+				}
 			}
+
+			std::swap(_rendertarget, _rendertarget2);
+			tex_cur = _rendertarget->get_texture();
 		}
 	}
 
@@ -442,6 +521,8 @@ std::shared_ptr<::gs::texture> gfx::blur::box_rotational::render()
 	return _rendertarget->get_texture();
 }
 
+gfx::blur::box_zoom::box_zoom() : _multipass(false) {}
+
 ::gfx::blur::type gfx::blur::box_zoom::get_type()
 {
 	return ::gfx::blur::type::Zoom;
@@ -459,6 +540,16 @@ void gfx::blur::box_zoom::get_center(double_t& x, double_t& y)
 	y = _center.second;
 }
 
+bool gfx::blur::box_zoom::get_multipass()
+{
+	return _multipass;
+}
+
+void gfx::blur::box_zoom::set_multipass(bool enabled)
+{
+	_multipass = enabled;
+}
+
 std::shared_ptr<::gs::texture> gfx::blur::box_zoom::render()
 {
 	auto    gctx   = gs::context();
@@ -478,22 +569,40 @@ std::shared_ptr<::gs::texture> gfx::blur::box_zoom::render()
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	// One Pass Blur
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
+	// One Pass Blur, or Multi-Pass Blur with growing steps.
+	//  Scaling around the center does not add up linearly like rotation does, but the error is
+	//  far below a single texel for the step scales this blur is used with.
+	std::shared_ptr<::gs::effect> effect =
+		_data->get_effect(_multipass ? std::min(_size, double_t(MULTIPASS_SIZE)) : _size);
 	if (effect) {
-		effect->get_parameter("pImage")->set_texture(_input_texture);
+		std::vector<std::pair<double_t, double_t>> passes;
+		if (_multipass) {
+			passes = box_multipass_steps(_size);
+		} else {
+			passes.emplace_back(_size, 1.);
+		}
+
 		effect->get_parameter("pImageTexel")->set_float2(float_t(1.f / width), float_t(1.f / height));
-		effect->get_parameter("pStepScale")->set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-		effect->get_parameter("pSize")->set_float(float_t(_size));
-		effect->get_parameter("pSizeInverseMul")->set_float(float_t(1.0f / (float_t(_size) * 2.0f + 1.0f)));
 		effect->get_parameter("pCenter")->set_float2(float_t(_center.first), float_t(_center.second));
 
-		{
-			auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
-			gs_ortho(0, 1., 0, 1., 0, 1.);
-			while (gs_effect_loop(effect->get_object(), "Zoom")) {
-				gs_draw_sprite(nullptr, 0, 1, 1);
+		std::shared_ptr<::gs::texture> tex_cur = _input_texture;
+		for (auto& pass : passes) {
+			effect->get_parameter("pImage")->set_texture(tex_cur);
+			effect->get_parameter("pStepScale")
+				->set_float2(float_t(_step_scale.first * pass.second), float_t(_step_scale.second * pass.second));
+			effect->get_parameter("pSize")->set_float(float_t(pass.first));
+			effect->get_parameter("pSizeInverseMul")->set_float(float_t(1.0f / (float_t(pass.first) * 2.0f + 1.0f)));
+
+			{
+				auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+				gs_ortho(0, 1., 0, 1., 0, 1.);
+				while (gs_effect_loop(effect->get_object(), "Zoom")) {
+					gs_draw_sprite(nullptr, 0, 1, 1);
+				}
 			}
+
+			std::swap(_rendertarget, _rendertarget2);
+			tex_cur = _rendertarget->get_texture();
 		}
 	}
 
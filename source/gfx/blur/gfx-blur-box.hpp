@@ -27,13 +27,13 @@
 namespace gfx {
 	namespace blur {
 		class box_data {
-			std::shared_ptr<::gs::effect> _effect;
+			std::shared_ptr<::gfx::blur::sized_effect> _effect;
 
 			public:
 			box_data();
 			virtual ~box_data();
 
-			std::shared_ptr<::gs::effect> get_effect();
+			std::shared_ptr<::gs::effect> get_effect(double_t size);
 		};
 
 		class box_factory : public ::gfx::blur::ifactory {
@@ -74,6 +74,10 @@ namespace gfx {
 
 			virtual double_t get_max_step_scale_y(::gfx::blur::type type) override;
 
+			virtual bool is_multipass_supported(::gfx::blur::type type) override;
+
+			virtual bool is_size_map_supported(::gfx::blur::type type) override;
+
 			std::shared_ptr<::gfx::blur::box_data> data();
 
 			public: // Singleton
@@ -88,8 +92,6 @@ namespace gfx {
 			std::pair<double_t, double_t>       _step_scale;
 			std::shared_ptr<::gs::texture>      _input_texture;
 			std::shared_ptr<::gs::rendertarget> _rendertarget;
-
-			private:
 			std::shared_ptr<::gs::rendertarget> _rendertarget2;
 
 			public:
@@ -128,11 +130,15 @@ namespace gfx {
 
 		class box_rotational : public ::gfx::blur::box,
 							   public ::gfx::blur::base_angle,
-							   public ::gfx::blur::base_center {
+							   public ::gfx::blur::base_center,
+							   public ::gfx::blur::base_multipass {
 			std::pair<double_t, double_t> _center;
 			double_t                      _angle;
+			bool                          _multipass;
 
 			public:
+			box_rotational();
+
 			virtual ::gfx::blur::type get_type() override;
 
 			virtual void set_center(double_t x, double_t y) override;
@@ -141,18 +147,29 @@ namespace gfx {
 			virtual double_t get_angle() override;
 			virtual void     set_angle(double_t angle) override;
 
+			virtual bool get_multipass() override;
+			virtual void set_multipass(bool enabled) override;
+
 			virtual std::shared_ptr<::gs::texture> render() override;
 		};
 
-		class box_zoom : public ::gfx::blur::box, public ::gfx::blur::base_center {
+		class box_zoom : public ::gfx::blur::box,
+						 public ::gfx::blur::base_center,
+						 public ::gfx::blur::base_multipass {
 			std::pair<double_t, double_t> _center;
+			bool                          _multipass;
 
 			public:
+			box_zoom();
+
 			virtual ::gfx::blur::type get_type() override;
 
 			virtual void set_center(double_t x, double_t y) override;
 			virtual void get_center(double_t& x, double_t& y) override;
 
+			virtual bool get_multipass() override;
+			virtual void set_multipass(bool enabled) override;
+
 			virtual std::shared_ptr<::gs::texture> render() override;
 		};
 	} // namespace blur
@@ -16,6 +16,8 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
 
 #include "gfx-blur-dual-filtering.hpp"
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
@@ -48,6 +50,11 @@
 //   6: 3 Iteration (8x), Arm Size 7, Offset Scale 0.75
 //   7: 3 Iteration (8x), Arm Size 8, Offset Scale 1.0
 //   ...
+//
+// With a size map, the size is scaled per pixel instead. Every upsampling step then blends
+//  between the level it upsamples to and the upsampled blur from the coarser levels, so each
+//  pixel stops picking up further blur once it reaches its own level. As the levels are the
+//  pyramid itself, this costs about as much as a regular blur at the maximum size.
 
 #define MAX_LEVELS 16
 
@@ -163,6 +170,16 @@ double_t gfx::blur::dual_filtering_factory::get_max_step_scale_y(::gfx::blur::ty
 	return double_t(0);
 }
 
+bool gfx::blur::dual_filtering_factory::is_multipass_supported(::gfx::blur::type)
+{
+	return false;
+}
+
+bool gfx::blur::dual_filtering_factory::is_size_map_supported(::gfx::blur::type)
+{
+	return true;
+}
+
 std::shared_ptr<::gfx::blur::dual_filtering_data> gfx::blur::dual_filtering_factory::data()
 {
 	std::unique_lock<std::mutex>                      ulock(_data_lock);
@@ -188,6 +205,10 @@ gfx::blur::dual_filtering::dual_filtering()
 	for (size_t n = 0; n <= MAX_LEVELS; n++) {
 		_rendertargets[n] = std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
 	}
+	_rendertargets_up.resize(MAX_LEVELS);
+	for (size_t n = 0; n < MAX_LEVELS; n++) {
+		_rendertargets_up[n] = std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
+	}
 }
 
 gfx::blur::dual_filtering::~dual_filtering() {}
@@ -229,6 +250,10 @@ std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::render()
 	}
 
 	size_t actual_iterations = _size_iterations;
+	if (_size_map) {
+		// Fractional sizes are handled by the blend between levels, so include the next level too.
+		actual_iterations = std::min(size_t(ceil(_size)), size_t(MAX_LEVELS));
+	}
 
 	gs_blend_state_push();
 	gs_reset_blend_state();
@@ -278,6 +303,54 @@ std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::render()
 		}
 	}
 
+	// Upsample with a size map, blending each level with the blur from the coarser levels.
+	if (_size_map) {
+		for (size_t n = actual_iterations; n > 0; n--) {
+			// Select Textures
+			std::shared_ptr<gs::texture> tex_cur;
+			if (n < actual_iterations) {
+				tex_cur = _rendertargets_up[n]->get_texture();
+			} else {
+				tex_cur = _rendertargets[n]->get_texture();
+			}
+			std::shared_ptr<gs::texture> tex_base;
+			if (n > 1) {
+				tex_base = _rendertargets[n - 1]->get_texture();
+			} else {
+				tex_base = _input_texture;
+			}
+
+			// Get Size
+			uint32_t width  = tex_cur->get_width();
+			uint32_t height = tex_cur->get_height();
+
+			// Apply
+			effect->get_parameter("pImage")->set_texture(tex_cur);
+			effect->get_parameter("pImageSize")->set_float2(float_t(width), float_t(height));
+			effect->get_parameter("pImageTexel")->set_float2(1.0f / width, 1.0f / height);
+			effect->get_parameter("pImageHalfTexel")->set_float2(0.5f / width, 0.5f / height);
+			effect->get_parameter("pImageBase")->set_texture(tex_base);
+			effect->get_parameter("pSizeMap")->set_texture(_size_map);
+			effect->get_parameter("pLevel")->set_float(float_t(n - 1));
+			effect->get_parameter("pLevels")->set_float(float_t(_size));
+
+			{
+				auto op = _rendertargets_up[n - 1]->render(tex_base->get_width(), tex_base->get_height());
+				gs_ortho(0., 1., 0., 1., 0., 1.);
+				while (gs_effect_loop(effect->get_object(), "UpSizeMap")) {
+					gs_draw_sprite(tex_cur->get_object(), 0, 1, 1);
+				}
+			}
+		}
+
+		gs_blend_state_pop();
+
+		if (actual_iterations == 0) {
+			return _input_texture;
+		}
+		return _rendertargets_up[0]->get_texture();
+	}
+
 	// Upsample
 	for (size_t n = actual_iterations; n > 0; n--) {
 		// Select Texture
@@ -313,5 +386,18 @@ std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::render()
 
 std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::get()
 {
+	if (_size_map) {
+		return _rendertargets_up[0]->get_texture();
+	}
 	return _rendertargets[0]->get_texture();
 }
+
+void gfx::blur::dual_filtering::set_size_map(std::shared_ptr<::gs::texture> texture)
+{
+	_size_map = texture;
+}
+
+std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::get_size_map()
+{
+	return _size_map;
+}
@@ -75,21 +75,27 @@ namespace gfx {
 
 			virtual double_t get_max_step_scale_y(::gfx::blur::type type) override;
 
+			virtual bool is_multipass_supported(::gfx::blur::type type) override;
+
+			virtual bool is_size_map_supported(::gfx::blur::type type) override;
+
 			std::shared_ptr<::gfx::blur::dual_filtering_data> data();
 
 			public: // Singleton
 			static ::gfx::blur::dual_filtering_factory& get();
 		};
 
-		class dual_filtering : public ::gfx::blur::base {
+		class dual_filtering : public ::gfx::blur::base, public ::gfx::blur::base_size_map {
 			std::shared_ptr<::gfx::blur::dual_filtering_data> _data;
 
 			double_t _size;
 			size_t   _size_iterations;
 
 			std::shared_ptr<gs::texture> _input_texture;
+			std::shared_ptr<gs::texture> _size_map;
 
 			std::vector<std::shared_ptr<gs::rendertarget>> _rendertargets;
+			std::vector<std::shared_ptr<gs::rendertarget>> _rendertargets_up;
 
 			public:
 			dual_filtering();
@@ -110,6 +116,11 @@ namespace gfx {
 			virtual std::shared_ptr<::gs::texture> render() override;
 
 			virtual std::shared_ptr<::gs::texture> get() override;
+
+			// Size Map
+			virtual void set_size_map(std::shared_ptr<::gs::texture> texture) override;
+
+			virtual std::shared_ptr<::gs::texture> get_size_map() override;
 		};
 	}; // namespace blur
 
@@ -0,0 +1,350 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-blur-gaussian-box.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+#include "util-math.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs-module.h>
+#include <obs.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// Gaussian Box Blur
+//
+// Approximates a Gaussian Blur with three passes of an extended box per direction. The
+//  extended box (Gwosdek et al.) adds a fractionally weighted tap on each side so that any
+//  sigma can be matched exactly instead of only the ones an integer box width would allow.
+//
+// To keep the cost per pixel independent of the size, the input is first reduced with a
+//  2x2 box until the remaining sigma is less than 4 texels, the boxes are applied at that
+//  level, and the result is upsampled with a single bilinear tap. The variance added by
+//  the reduction and the upsampling is subtracted from the target variance, so the final
+//  result still matches the requested sigma:
+//   - Downsampling L times adds (4^L - 1) / 12.
+//   - Bilinear upsampling from level L adds 4^L / 6.
+//
+// The size is treated as the radius of the kernel, which is three times sigma.
+
+#define MAX_BLUR_SIZE 1024
+#define MAX_LEVELS 8
+#define MAX_BOX_RADIUS 4 // Also change this in gaussian-box.effect if modified.
+#define BOX_PASSES 3
+#define LEVEL_THRESHOLD 4.
+
+gfx::blur::gaussian_box_data::gaussian_box_data()
+{
+	auto gctx = gs::context();
+	try {
+		char* file = obs_module_file("effects/blur/gaussian-box.effect");
+		_effect    = std::make_shared<::gs::effect>(file);
+		bfree(file);
+	} catch (...) {
+		P_LOG_ERROR("<gfx::blur::gaussian_box> Failed to load _effect.");
+	}
+}
+
+gfx::blur::gaussian_box_data::~gaussian_box_data()
+{
+	auto gctx = gs::context();
+	_effect.reset();
+}
+
+std::shared_ptr<::gs::effect> gfx::blur::gaussian_box_data::get_effect()
+{
+	return _effect;
+}
+
+gfx::blur::gaussian_box_factory::gaussian_box_factory() {}
+
+gfx::blur::gaussian_box_factory::~gaussian_box_factory() {}
+
+bool gfx::blur::gaussian_box_factory::is_type_supported(::gfx::blur::type type)
+{
+	switch (type) {
+	case ::gfx::blur::type::Area:
+		return true;
+	default:
+		return false;
+	}
+}
+
+std::shared_ptr<::gfx::blur::base> gfx::blur::gaussian_box_factory::create(::gfx::blur::type type)
+{
+	switch (type) {
+	case ::gfx::blur::type::Area:
+		return std::make_shared<::gfx::blur::gaussian_box>();
+	default:
+		throw std::runtime_error("Invalid type.");
+	}
+}
+
+double_t gfx::blur::gaussian_box_factory::get_min_size(::gfx::blur::type)
+{
+	return double_t(1.0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_step_size(::gfx::blur::type)
+{
+	return double_t(1.0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_max_size(::gfx::blur::type)
+{
+	return double_t(MAX_BLUR_SIZE);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_min_angle(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_step_angle(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_max_angle(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+bool gfx::blur::gaussian_box_factory::is_step_scale_supported(::gfx::blur::type)
+{
+	return false;
+}
+
+double_t gfx::blur::gaussian_box_factory::get_min_step_scale_x(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_step_step_scale_x(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_max_step_scale_x(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_min_step_scale_y(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_step_step_scale_y(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t gfx::blur::gaussian_box_factory::get_max_step_scale_y(::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+bool gfx::blur::gaussian_box_factory::is_multipass_supported(::gfx::blur::type)
+{
+	return false;
+}
+
+bool gfx::blur::gaussian_box_factory::is_size_map_supported(::gfx::blur::type)
+{
+	return false;
+}
+
+std::shared_ptr<::gfx::blur::gaussian_box_data> gfx::blur::gaussian_box_factory::data()
+{
+	std::unique_lock<std::mutex>                    ulock(_data_lock);
+	std::shared_ptr<::gfx::blur::gaussian_box_data> data = _data.lock();
+	if (!data) {
+		data  = std::make_shared<::gfx::blur::gaussian_box_data>();
+		_data = data;
+	}
+	return data;
+}
+
+::gfx::blur::gaussian_box_factory& gfx::blur::gaussian_box_factory::get()
+{
+	static ::gfx::blur::gaussian_box_factory instance;
+	return instance;
+}
+
+gfx::blur::gaussian_box::gaussian_box() : _data(::gfx::blur::gaussian_box_factory::get().data()), _size(1.)
+{
+	auto gctx = gs::context();
+	_levels.resize(MAX_LEVELS);
+	for (size_t n = 0; n < MAX_LEVELS; n++) {
+		_levels[n] = std::make_shared<::gs::rendertarget>(GS_RGBA16F, GS_ZS_NONE);
+	}
+	_rendertarget  = std::make_shared<::gs::rendertarget>(GS_RGBA16F, GS_ZS_NONE);
+	_rendertarget2 = std::make_shared<::gs::rendertarget>(GS_RGBA16F, GS_ZS_NONE);
+}
+
+gfx::blur::gaussian_box::~gaussian_box() {}
+
+void gfx::blur::gaussian_box::set_input(std::shared_ptr<::gs::texture> texture)
+{
+	_input_texture = texture;
+}
+
+::gfx::blur::type gfx::blur::gaussian_box::get_type()
+{
+	return ::gfx::blur::type::Area;
+}
+
+double_t gfx::blur::gaussian_box::get_size()
+{
+	return _size;
+}
+
+void gfx::blur::gaussian_box::set_size(double_t width)
+{
+	if (width < 1.)
+		width = 1.;
+	if (width > MAX_BLUR_SIZE)
+		width = MAX_BLUR_SIZE;
+	_size = width;
+}
+
+void gfx::blur::gaussian_box::set_step_scale(double_t, double_t) {}
+
+void gfx::blur::gaussian_box::get_step_scale(double_t&, double_t&) {}
+
+std::shared_ptr<::gs::texture> gfx::blur::gaussian_box::render()
+{
+	auto gctx   = gs::context();
+	auto effect = _data->get_effect();
+	if (!effect) {
+		return _input_texture;
+	}
+
+	uint32_t width  = _input_texture->get_width();
+	uint32_t height = _input_texture->get_height();
+	double_t sigma  = _size / 3.;
+
+	// Find the level at which the remaining sigma fits into the box shader.
+	size_t levels = 0;
+	while ((levels < MAX_LEVELS) && ((sigma / double_t(1ull << levels)) >= LEVEL_THRESHOLD)
+		   && ((width >> (levels + 1)) > 0) && ((height >> (levels + 1)) > 0)) {
+		levels++;
+	}
+
+	// Variance that is left for the boxes, in texels of the selected level.
+	double_t scale    = double_t(1ull << levels);
+	double_t variance = (sigma * sigma) / (scale * scale);
+	if (levels > 0) {
+		variance -= (1. - 1. / (scale * scale)) / 12. + 1. / 6.;
+	}
+	variance = std::max(variance, 0.) / BOX_PASSES;
+
+	// Extended Box parameters.
+	double_t radius = floor(0.5 * sqrt(12. * variance + 1.) - 0.5);
+	radius          = std::min(radius, double_t(MAX_BOX_RADIUS - 1));
+	double_t alpha  = ((2. * radius + 1.) * (radius * (radius + 1.) - 3. * variance))
+					 / (6. * (variance - (radius + 1.) * (radius + 1.)));
+	alpha = std::max(std::min(alpha, 1.), 0.);
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	// Downsample
+	std::shared_ptr<::gs::texture> tex_cur = _input_texture;
+	for (size_t n = 1; n <= levels; n++) {
+		effect->get_parameter("pImage")->set_texture(tex_cur);
+
+		{
+			auto op = _levels[n - 1]->render(std::max(width >> n, 1u), std::max(height >> n, 1u));
+			gs_ortho(0., 1., 0., 1., 0., 1.);
+			while (gs_effect_loop(effect->get_object(), "Scale")) {
+				gs_draw_sprite(nullptr, 0, 1, 1);
+			}
+		}
+
+		tex_cur = _levels[n - 1]->get_texture();
+	}
+
+	// Extended Box, horizontal passes first and vertical passes second.
+	uint32_t level_width  = tex_cur->get_width();
+	uint32_t level_height = tex_cur->get_height();
+	effect->get_parameter("pRadius")->set_float(float_t(radius));
+	effect->get_parameter("pAlpha")->set_float(float_t(alpha));
+	effect->get_parameter("pSizeInverseMul")->set_float(float_t(1. / (2. * radius + 1. + 2. * alpha)));
+	for (size_t pass = 0; pass < (BOX_PASSES * 2); pass++) {
+		effect->get_parameter("pImage")->set_texture(tex_cur);
+		if (pass < BOX_PASSES) {
+			effect->get_parameter("pImageTexel")->set_float2(float_t(1. / level_width), 0.f);
+		} else {
+			effect->get_parameter("pImageTexel")->set_float2(0.f, float_t(1. / level_height));
+		}
+
+		{
+			auto op = _rendertarget2->render(level_width, level_height);
+			gs_ortho(0., 1., 0., 1., 0., 1.);
+			while (gs_effect_loop(effect->get_object(), "Box")) {
+				gs_draw_sprite(nullptr, 0, 1, 1);
+			}
+		}
+
+		std::swap(_rendertarget, _rendertarget2);
+		tex_cur = _rendertarget->get_texture();
+	}
+
+	// Upsample
+	if (levels > 0) {
+		effect->get_parameter("pImage")->set_texture(tex_cur);
+
+		{
+			auto op = _rendertarget2->render(width, height);
+			gs_ortho(0., 1., 0., 1., 0., 1.);
+			while (gs_effect_loop(effect->get_object(), "Scale")) {
+				gs_draw_sprite(nullptr, 0, 1, 1);
+			}
+		}
+
+		std::swap(_rendertarget, _rendertarget2);
+	}
+
+	gs_blend_state_pop();
+
+	return this->get();
+}
+
+std::shared_ptr<::gs::texture> gfx::blur::gaussian_box::get()
+{
+	return _rendertarget->get_texture();
+}
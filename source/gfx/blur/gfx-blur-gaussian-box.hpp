@@ -0,0 +1,120 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "gfx-blur-base.hpp"
+#include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+namespace gfx {
+	namespace blur {
+		class gaussian_box_data {
+			std::shared_ptr<::gs::effect> _effect;
+
+			public:
+			gaussian_box_data();
+			virtual ~gaussian_box_data();
+
+			std::shared_ptr<::gs::effect> get_effect();
+		};
+
+		class gaussian_box_factory : public ::gfx::blur::ifactory {
+			std::mutex                                    _data_lock;
+			std::weak_ptr<::gfx::blur::gaussian_box_data> _data;
+
+			public:
+			gaussian_box_factory();
+			virtual ~gaussian_box_factory() override;
+
+			virtual bool is_type_supported(::gfx::blur::type type) override;
+
+			virtual std::shared_ptr<::gfx::blur::base> create(::gfx::blur::type type) override;
+
+			virtual double_t get_min_size(::gfx::blur::type type) override;
+
+			virtual double_t get_step_size(::gfx::blur::type type) override;
+
+			virtual double_t get_max_size(::gfx::blur::type type) override;
+
+			virtual double_t get_min_angle(::gfx::blur::type type) override;
+
+			virtual double_t get_step_angle(::gfx::blur::type type) override;
+
+			virtual double_t get_max_angle(::gfx::blur::type type) override;
+
+			virtual bool is_step_scale_supported(::gfx::blur::type type) override;
+
+			virtual double_t get_min_step_scale_x(::gfx::blur::type type) override;
+
+			virtual double_t get_step_step_scale_x(::gfx::blur::type type) override;
+
+			virtual double_t get_max_step_scale_x(::gfx::blur::type type) override;
+
+			virtual double_t get_min_step_scale_y(::gfx::blur::type type) override;
+
+			virtual double_t get_step_step_scale_y(::gfx::blur::type type) override;
+
+			virtual double_t get_max_step_scale_y(::gfx::blur::type type) override;
+
+			virtual bool is_multipass_supported(::gfx::blur::type type) override;
+
+			virtual bool is_size_map_supported(::gfx::blur::type type) override;
+
+			std::shared_ptr<::gfx::blur::gaussian_box_data> data();
+
+			public: // Singleton
+			static ::gfx::blur::gaussian_box_factory& get();
+		};
+
+		class gaussian_box : public ::gfx::blur::base {
+			std::shared_ptr<::gfx::blur::gaussian_box_data> _data;
+
+			double_t _size;
+
+			std::shared_ptr<::gs::texture> _input_texture;
+
+			std::vector<std::shared_ptr<::gs::rendertarget>> _levels;
+			std::shared_ptr<::gs::rendertarget>              _rendertarget;
+			std::shared_ptr<::gs::rendertarget>              _rendertarget2;
+
+			public:
+			gaussian_box();
+			virtual ~gaussian_box() override;
+
+			virtual void set_input(std::shared_ptr<::gs::texture> texture) override;
+
+			virtual ::gfx::blur::type get_type() override;
+
+			virtual double_t get_size() override;
+
+			virtual void set_size(double_t width) override;
+
+			virtual void set_step_scale(double_t x, double_t y) override;
+
+			virtual void get_step_scale(double_t& x, double_t& y) override;
+
+			virtual std::shared_ptr<::gs::texture> render() override;
+
+			virtual std::shared_ptr<::gs::texture> get() override;
+		};
+	} // namespace blur
+} // namespace gfx
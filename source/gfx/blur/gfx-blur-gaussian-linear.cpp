@@ -215,6 +215,16 @@ double_t gfx::blur::gaussian_linear_factory::get_max_step_scale_y(::gfx::blur::t
 	return double_t(1000.0);
 }
 
+bool gfx::blur::gaussian_linear_factory::is_multipass_supported(::gfx::blur::type)
+{
+	return false;
+}
+
+bool gfx::blur::gaussian_linear_factory::is_size_map_supported(::gfx::blur::type)
+{
+	return false;
+}
+
 std::shared_ptr<::gfx::blur::gaussian_linear_data> gfx::blur::gaussian_linear_factory::data()
 {
 	std::unique_lock<std::mutex>                       ulock(_data_lock);
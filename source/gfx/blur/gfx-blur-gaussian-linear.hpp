@@ -76,6 +76,10 @@ namespace gfx {
 
 			virtual double_t get_max_step_scale_y(::gfx::blur::type type) override;
 
+			virtual bool is_multipass_supported(::gfx::blur::type type) override;
+
+			virtual bool is_size_map_supported(::gfx::blur::type type) override;
+
 			std::shared_ptr<::gfx::blur::gaussian_linear_data> data();
 
 			public: // Singleton
@@ -16,6 +16,7 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
 
 #include "gfx-blur-gaussian.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
@@ -41,13 +42,16 @@
 #define SEARCH_THRESHOLD double_t(1. / (MAX_KERNEL_SIZE * 5))
 #define SEARCH_EXTENSION 1
 #define SEARCH_RANGE MAX_KERNEL_SIZE * 2
+#define MULTIPASS_SIZE 8
+#define MULTIPASS_GROWTH 3.
+#define MULTIPASS_THRESHOLD 0.01
 
 gfx::blur::gaussian_data::gaussian_data()
 {
 	auto gctx = gs::context();
 	{
 		char* file = obs_module_file("effects/blur/gaussian.effect");
-		_effect    = gs::effect::create(file);
+		_effect    = std::make_shared<::gfx::blur::sized_effect>(file, MAX_BLUR_SIZE);
 		bfree(file);
 	}
 
@@ -88,9 +92,12 @@ gfx::blur::gaussian_data::~gaussian_data()
 	_effect.reset();
 }
 
-std::shared_ptr<::gs::effect> gfx::blur::gaussian_data::get_effect()
+std::shared_ptr<::gs::effect> gfx::blur::gaussian_data::get_effect(double_t size)
 {
-	return _effect;
+	if (!_effect) {
+		return nullptr;
+	}
+	return _effect->get(size);
 }
 
 std::vector<float_t> const& gfx::blur::gaussian_data::get_kernel(size_t width)
@@ -103,6 +110,51 @@ std::vector<float_t> const& gfx::blur::gaussian_data::get_kernel(size_t width)
 	return _kernels[width];
 }
 
+double_t gfx::blur::gaussian_data::get_kernel_variance(size_t width)
+{
+	auto const& kernel   = get_kernel(width);
+	double_t    variance = 0.;
+	for (size_t p = 1; p < kernel.size(); p++) {
+		variance += 2. * double_t(kernel[p]) * double_t(p * p);
+	}
+	return variance;
+}
+
+// Multi-Pass Gaussian Blur
+//
+// Splits the kernel of the given size into passes of the MULTIPASS_SIZE kernel, with the step
+//  growing by MULTIPASS_GROWTH after each pass. The growth is small enough that every pass only
+//  samples an image that is already smooth at its step size. Since the variance of consecutive
+//  Gaussian passes adds up, passes are added until the variance of the original kernel is
+//  reached, with the last pass using a shorter step to cover the remainder exactly.
+//
+// Returns a list of (size, step multiplier) pairs, one for each pass.
+static std::vector<std::pair<double_t, double_t>> gaussian_multipass_steps(gfx::blur::gaussian_data& data,
+																		   double_t                  size)
+{
+	std::vector<std::pair<double_t, double_t>> passes;
+	if (size <= MULTIPASS_SIZE) {
+		passes.emplace_back(size, 1.);
+		return passes;
+	}
+
+	double_t target        = data.get_kernel_variance(size_t(size));
+	double_t pass_variance = data.get_kernel_variance(MULTIPASS_SIZE);
+	double_t total         = 0.;
+	double_t step          = 1.;
+	while ((target - total) > (target * MULTIPASS_THRESHOLD)) {
+		double_t remaining = target - total;
+		if ((pass_variance * step * step) > remaining) {
+			passes.emplace_back(double_t(MULTIPASS_SIZE), sqrt(remaining / pass_variance));
+			break;
+		}
+		passes.emplace_back(double_t(MULTIPASS_SIZE), step);
+		total += pass_variance * step * step;
+		step *= MULTIPASS_GROWTH;
+	}
+	return passes;
+}
+
 gfx::blur::gaussian_factory::gaussian_factory() {}
 
 gfx::blur::gaussian_factory::~gaussian_factory() {}
@@ -223,6 +275,22 @@ double_t gfx::blur::gaussian_factory::get_max_step_scale_y(::gfx::blur::type)
 	return double_t(1000.0);
 }
 
+bool gfx::blur::gaussian_factory::is_multipass_supported(::gfx::blur::type v)
+{
+	switch (v) {
+	case ::gfx::blur::type::Rotational:
+	case ::gfx::blur::type::Zoom:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool gfx::blur::gaussian_factory::is_size_map_supported(::gfx::blur::type)
+{
+	return false;
+}
+
 std::shared_ptr<::gfx::blur::gaussian_data> gfx::blur::gaussian_factory::data()
 {
 	std::unique_lock<std::mutex>                ulock(_data_lock);
@@ -299,7 +367,7 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian::render()
 {
 	auto gctx = gs::context();
 
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
+	std::shared_ptr<::gs::effect> effect = _data->get_effect(_size);
 	auto                          kernel = _data->get_kernel(size_t(_size));
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
@@ -392,7 +460,7 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_directional::render()
 {
 	auto gctx = gs::context();
 
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
+	std::shared_ptr<::gs::effect> effect = _data->get_effect(_size);
 	auto                          kernel = _data->get_kernel(size_t(_size));
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
@@ -438,6 +506,8 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_directional::render()
 	return this->get();
 }
 
+gfx::blur::gaussian_rotational::gaussian_rotational() : m_angle(0.), m_multipass(false) {}
+
 ::gfx::blur::type gfx::blur::gaussian_rotational::get_type()
 {
 	return ::gfx::blur::type::Rotational;
@@ -447,8 +517,8 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_rotational::render()
 {
 	auto gctx = gs::context();
 
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
-	auto                          kernel = _data->get_kernel(size_t(_size));
+	std::shared_ptr<::gs::effect> effect =
+		_data->get_effect(m_multipass ? std::min(_size, double_t(MULTIPASS_SIZE)) : _size);
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
@@ -471,21 +541,35 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_rotational::render()
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	effect->get_parameter("pImage")->set_texture(_input_texture);
 	effect->get_parameter("pImageTexel")->set_float2(float_t(1.f / width), float_t(1.f / height));
 	effect->get_parameter("pStepScale")->set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-	effect->get_parameter("pSize")->set_float(float_t(_size));
-	effect->get_parameter("pAngle")->set_float(float_t(m_angle / _size));
 	effect->get_parameter("pCenter")->set_float2(float_t(m_center.first), float_t(m_center.second));
-	effect->get_parameter("pKernel")->set_float_array(kernel.data(), MAX_KERNEL_SIZE);
 
-	// First Pass
-	{
-		auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
-		gs_ortho(0, 1., 0, 1., 0, 1.);
-		while (gs_effect_loop(effect->get_object(), "Rotate")) {
-			gs_draw_sprite(nullptr, 0, 1, 1);
+	std::vector<std::pair<double_t, double_t>> passes;
+	if (m_multipass) {
+		passes = gaussian_multipass_steps(*_data, _size);
+	} else {
+		passes.emplace_back(_size, 1.);
+	}
+
+	std::shared_ptr<::gs::texture> tex_cur = _input_texture;
+	for (auto& pass : passes) {
+		auto pass_kernel = _data->get_kernel(size_t(pass.first));
+		effect->get_parameter("pImage")->set_texture(tex_cur);
+		effect->get_parameter("pSize")->set_float(float_t(pass.first));
+		effect->get_parameter("pAngle")->set_float(float_t(m_angle / _size * pass.second));
+		effect->get_parameter("pKernel")->set_float_array(pass_kernel.data(), MAX_KERNEL_SIZE);
+
+		{
+			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			gs_ortho(0, 1., 0, 1., 0, 1.);
+			while (gs_effect_loop(effect->get_object(), "Rotate")) {
+				gs_draw_sprite(nullptr, 0, 1, 1);
+			}
 		}
+
+		std::swap(_rendertarget, _rendertarget2);
+		tex_cur = _rendertarget->get_texture();
 	}
 
 	gs_blend_state_pop();
@@ -515,6 +599,18 @@ void gfx::blur::gaussian_rotational::set_angle(double_t angle)
 	m_angle = D_DEG_TO_RAD(angle);
 }
 
+bool gfx::blur::gaussian_rotational::get_multipass()
+{
+	return m_multipass;
+}
+
+void gfx::blur::gaussian_rotational::set_multipass(bool enabled)
+{
+	m_multipass = enabled;
+}
+
+gfx::blur::gaussian_zoom::gaussian_zoom() : m_multipass(false) {}
+
 ::gfx::blur::type gfx::blur::gaussian_zoom::get_type()
 {
 	return ::gfx::blur::type::Zoom;
@@ -524,8 +620,8 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_zoom::render()
 {
 	auto gctx = gs::context();
 
-	std::shared_ptr<::gs::effect> effect = _data->get_effect();
-	auto                          kernel = _data->get_kernel(size_t(_size));
+	std::shared_ptr<::gs::effect> effect =
+		_data->get_effect(m_multipass ? std::min(_size, double_t(MULTIPASS_SIZE)) : _size);
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
@@ -548,20 +644,35 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_zoom::render()
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	effect->get_parameter("pImage")->set_texture(_input_texture);
 	effect->get_parameter("pImageTexel")->set_float2(float_t(1.f / width), float_t(1.f / height));
-	effect->get_parameter("pStepScale")->set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-	effect->get_parameter("pSize")->set_float(float_t(_size));
 	effect->get_parameter("pCenter")->set_float2(float_t(m_center.first), float_t(m_center.second));
-	effect->get_parameter("pKernel")->set_float_array(kernel.data(), MAX_KERNEL_SIZE);
 
-	// First Pass
-	{
-		auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
-		gs_ortho(0, 1., 0, 1., 0, 1.);
-		while (gs_effect_loop(effect->get_object(), "Zoom")) {
-			gs_draw_sprite(nullptr, 0, 1, 1);
+	std::vector<std::pair<double_t, double_t>> passes;
+	if (m_multipass) {
+		passes = gaussian_multipass_steps(*_data, _size);
+	} else {
+		passes.emplace_back(_size, 1.);
+	}
+
+	std::shared_ptr<::gs::texture> tex_cur = _input_texture;
+	for (auto& pass : passes) {
+		auto pass_kernel = _data->get_kernel(size_t(pass.first));
+		effect->get_parameter("pImage")->set_texture(tex_cur);
+		effect->get_parameter("pStepScale")
+			->set_float2(float_t(_step_scale.first * pass.second), float_t(_step_scale.second * pass.second));
+		effect->get_parameter("pSize")->set_float(float_t(pass.first));
+		effect->get_parameter("pKernel")->set_float_array(pass_kernel.data(), MAX_KERNEL_SIZE);
+
+		{
+			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			gs_ortho(0, 1., 0, 1., 0, 1.);
+			while (gs_effect_loop(effect->get_object(), "Zoom")) {
+				gs_draw_sprite(nullptr, 0, 1, 1);
+			}
 		}
+
+		std::swap(_rendertarget, _rendertarget2);
+		tex_cur = _rendertarget->get_texture();
 	}
 
 	gs_blend_state_pop();
@@ -580,3 +691,13 @@ void gfx::blur::gaussian_zoom::get_center(double_t& x, double_t& y)
 	x = m_center.first;
 	y = m_center.second;
 }
+
+bool gfx::blur::gaussian_zoom::get_multipass()
+{
+	return m_multipass;
+}
+
+void gfx::blur::gaussian_zoom::set_multipass(bool enabled)
+{
+	m_multipass = enabled;
+}
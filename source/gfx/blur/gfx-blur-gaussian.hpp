@@ -36,6 +36,8 @@ namespace gfx {
 			std::shared_ptr<::gs::effect> get_effect();
 
 			std::vector<float_t> const& get_kernel(size_t width);
+
+			double_t get_kernel_variance(size_t width);
 		};
 
 		class gaussian_factory : public ::gfx::blur::ifactory {
@@ -76,6 +78,10 @@ namespace gfx {
 
 			virtual double_t get_max_step_scale_y(::gfx::blur::type type) override;
 
+			virtual bool is_multipass_supported(::gfx::blur::type type) override;
+
+			virtual bool is_size_map_supported(::gfx::blur::type type) override;
+
 			std::shared_ptr<::gfx::blur::gaussian_data> data();
 
 			public: // Singleton
@@ -90,8 +96,6 @@ namespace gfx {
 			std::pair<double_t, double_t>       _step_scale;
 			std::shared_ptr<::gs::texture>      _input_texture;
 			std::shared_ptr<::gs::rendertarget> _rendertarget;
-
-			private:
 			std::shared_ptr<::gs::rendertarget> _rendertarget2;
 
 			public:
@@ -136,11 +140,15 @@ namespace gfx {
 
 		class gaussian_rotational : public ::gfx::blur::gaussian,
 									public ::gfx::blur::base_angle,
-									public ::gfx::blur::base_center {
+									public ::gfx::blur::base_center,
+									public ::gfx::blur::base_multipass {
 			std::pair<double_t, double_t> m_center;
 			double_t                      m_angle;
+			bool                          m_multipass;
 
 			public:
+			gaussian_rotational();
+
 			virtual ::gfx::blur::type get_type() override;
 
 			virtual void set_center(double_t x, double_t y) override;
@@ -149,18 +157,29 @@ namespace gfx {
 			virtual double_t get_angle() override;
 			virtual void     set_angle(double_t angle) override;
 
+			virtual bool get_multipass() override;
+			virtual void set_multipass(bool enabled) override;
+
 			virtual std::shared_ptr<::gs::texture> render() override;
 		};
 
-		class gaussian_zoom : public ::gfx::blur::gaussian, public ::gfx::blur::base_center {
+		class gaussian_zoom : public ::gfx::blur::gaussian,
+							  public ::gfx::blur::base_center,
+							  public ::gfx::blur::base_multipass {
 			std::pair<double_t, double_t> m_center;
+			bool                          m_multipass;
 
 			public:
+			gaussian_zoom();
+
 			virtual ::gfx::blur::type get_type() override;
 
 			virtual void set_center(double_t x, double_t y) override;
 			virtual void get_center(double_t& x, double_t& y) override;
 
+			virtual bool get_multipass() override;
+			virtual void set_multipass(bool enabled) override;
+
 			virtual std::shared_ptr<::gs::texture> render() override;
 		};
 	} // namespace blur
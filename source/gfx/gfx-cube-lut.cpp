@@ -0,0 +1,199 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-cube-lut.hpp"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+#include "util-threadpool.hpp"
+
+#define MAX_SIZE_1D 16384 // Limited by the maximum texture width.
+#define MAX_SIZE_3D 128 // Limited by the maximum texture width, which is size^2.
+
+// Tables that are queued or being parsed, so that the plugin can wait for them before it is unloaded.
+static std::shared_ptr<util::threadpool::group> cube_lut_jobs = std::make_shared<util::threadpool::group>();
+
+gfx::cube_lut::cube_lut(std::string file) : _state(std::make_shared<state>())
+{
+	_state->cancel = false;
+	_state->ready  = false;
+	_state->failed = false;
+	_state->size   = 0;
+	_state->is_3d  = false;
+	vec3_set(&_state->domain_min, 0., 0., 0.);
+	vec3_set(&_state->domain_max, 1., 1., 1.);
+
+	// The task only shares the state, so that it can finish on its own after the table is gone.
+	std::shared_ptr<util::threadpool> pool = util::threadpool::get();
+	if (!pool) {
+		_state->failed = true;
+		return;
+	}
+	pool->push(std::bind(&gfx::cube_lut::parse, _state, file), cube_lut_jobs);
+}
+
+gfx::cube_lut::~cube_lut()
+{
+	_state->cancel = true;
+}
+
+void gfx::cube_lut::wait_for_jobs()
+{
+	cube_lut_jobs->wait();
+}
+
+void gfx::cube_lut::parse(std::shared_ptr<state> lut, std::string file)
+try {
+	std::ifstream filestream = std::ifstream(file, std::ios::in);
+	if (!filestream.good()) {
+		throw std::ios_base::failure(file);
+	}
+
+	std::vector<float_t> entries;
+	std::string          line;
+	while (!lut->cancel && std::getline(filestream, line)) {
+		// Skip empty lines and comments.
+		size_t start = line.find_first_not_of(" \t\r");
+		if ((start == std::string::npos) || (line[start] == '#')) {
+			continue;
+		}
+
+		std::istringstream stream(line.substr(start));
+		std::string        keyword;
+		if ((line[start] == '-') || (line[start] == '.') || ((line[start] >= '0') && (line[start] <= '9'))) {
+			float_t r, g, b;
+			if (!(stream >> r >> g >> b)) {
+				throw std::runtime_error("Invalid table entry.");
+			}
+			entries.push_back(r);
+			entries.push_back(g);
+			entries.push_back(b);
+			entries.push_back(1.);
+			continue;
+		}
+
+		stream >> keyword;
+		if (keyword == "LUT_1D_SIZE") {
+			stream >> lut->size;
+			lut->is_3d = false;
+		} else if (keyword == "LUT_3D_SIZE") {
+			stream >> lut->size;
+			lut->is_3d = true;
+		} else if ((keyword == "DOMAIN_MIN") || (keyword == "LUT_1D_INPUT_RANGE")
+				   || (keyword == "LUT_3D_INPUT_RANGE")) {
+			if (keyword == "DOMAIN_MIN") {
+				stream >> lut->domain_min.x >> lut->domain_min.y >> lut->domain_min.z;
+			} else {
+				// Range variant, which applies the same range to all channels.
+				float_t min, max;
+				stream >> min >> max;
+				vec3_set(&lut->domain_min, min, min, min);
+				vec3_set(&lut->domain_max, max, max, max);
+			}
+		} else if (keyword == "DOMAIN_MAX") {
+			stream >> lut->domain_max.x >> lut->domain_max.y >> lut->domain_max.z;
+		}
+		// Everything else, like TITLE, does not change the result.
+	}
+	if (lut->cancel) {
+		return;
+	}
+
+	uint32_t size = lut->size;
+	if ((size < 2) || (size > (lut->is_3d ? MAX_SIZE_3D : MAX_SIZE_1D))) {
+		throw std::runtime_error("Unsupported table size.");
+	}
+	size_t count = lut->is_3d ? (size_t(size) * size * size) : size_t(size);
+	if (entries.size() != (count * 4)) {
+		throw std::runtime_error("Table size does not match the number of entries.");
+	}
+
+	if (lut->is_3d) {
+		// Entries are stored with red changing fastest and blue slowest, which is rearranged so that each blue
+		//  value is a slice of red (x) and green (y).
+		lut->data.resize(entries.size());
+		for (size_t b = 0; b < size; b++) {
+			for (size_t g = 0; g < size; g++) {
+				for (size_t r = 0; r < size; r++) {
+					size_t src = (r + g * size + b * size * size) * 4;
+					size_t dst = (r + b * size + g * size * size) * 4;
+					std::copy(entries.begin() + src, entries.begin() + src + 4, lut->data.begin() + dst);
+				}
+			}
+		}
+	} else {
+		lut->data.swap(entries);
+	}
+	lut->ready = true;
+} catch (const std::exception& ex) {
+	P_LOG_ERROR("<gfx::cube_lut> Loading '%s' failed with error(s): %s", file.c_str(), ex.what());
+	lut->failed = true;
+}
+
+bool gfx::cube_lut::is_ready()
+{
+	return _state->ready;
+}
+
+bool gfx::cube_lut::has_failed()
+{
+	return _state->failed;
+}
+
+uint32_t gfx::cube_lut::get_size()
+{
+	return _state->size;
+}
+
+bool gfx::cube_lut::is_3d()
+{
+	return _state->is_3d;
+}
+
+vec3 gfx::cube_lut::get_domain_min()
+{
+	return _state->domain_min;
+}
+
+vec3 gfx::cube_lut::get_domain_max()
+{
+	return _state->domain_max;
+}
+
+std::shared_ptr<gs::texture> gfx::cube_lut::get_texture()
+{
+	std::unique_lock<std::mutex> ulock(_lock);
+	if (!_texture && _state->ready) {
+		auto           gctx = gs::context();
+		uint32_t       size = _state->size;
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(_state->data.data());
+		if (_state->is_3d) {
+			_texture =
+				std::make_shared<gs::texture>(size * size, size, GS_RGBA32F, 1, &data, gs::texture::flags::None);
+		} else {
+			_texture = std::make_shared<gs::texture>(size, 1, GS_RGBA32F, 1, &data, gs::texture::flags::None);
+		}
+
+		// The table is no longer needed once it is on the GPU.
+		std::vector<float_t>().swap(_state->data);
+	}
+	return _texture;
+}
@@ -0,0 +1,86 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "obs/gs/gs-texture.hpp"
+
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <graphics/vec3.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace gfx {
+	// Adobe Cube LUT (.cube) with either a 1D or a 3D table.
+	//
+	// The file is parsed on the shared thread pool, as parsing large tables takes long enough to be noticed on the
+	//  graphics thread. Destroying the table cancels parsing instead of waiting for it. Nothing but is_ready() and
+	//  has_failed() may be used until it is ready. The table is only uploaded to the GPU on the first call to
+	//  get_texture(). 3D tables are uploaded with the blue slices next to each other, resulting in a texture of
+	//  size^2 x size, 1D tables as a texture of size x 1.
+	class cube_lut {
+		struct state {
+			std::atomic<bool>    cancel;
+			std::atomic<bool>    ready;
+			std::atomic<bool>    failed;
+			uint32_t             size;
+			bool                 is_3d;
+			vec3                 domain_min;
+			vec3                 domain_max;
+			std::vector<float_t> data;
+		};
+
+		std::shared_ptr<state>       _state;
+		std::mutex                   _lock;
+		std::shared_ptr<gs::texture> _texture;
+
+		public:
+		cube_lut(std::string file);
+		~cube_lut();
+
+		// Waits until all tables have finished or cancelled parsing, for before the plugin is unloaded.
+		static void wait_for_jobs();
+
+		bool is_ready();
+
+		// Returns true if the file could not be parsed.
+		bool has_failed();
+
+		uint32_t get_size();
+
+		bool is_3d();
+
+		vec3 get_domain_min();
+
+		vec3 get_domain_max();
+
+		std::shared_ptr<gs::texture> get_texture();
+
+		private:
+		static void parse(std::shared_ptr<state> lut, std::string file);
+	};
+} // namespace gfx
@@ -0,0 +1,302 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-distance-field.hpp"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+#include "util-threadpool.hpp"
+
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <graphics/graphics.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#define MAX_DISTANCE 65536.0 // Also change this in sdf-producer.effect and sdf-consumer.effect if modified.
+
+// Fields that are queued or being generated, so that the plugin can wait for them before it is unloaded.
+static std::shared_ptr<util::threadpool::group> field_jobs = std::make_shared<util::threadpool::group>();
+
+// Splits [0, count) into one block per worker of the thread pool. The calling thread works on the blocks as well,
+//  and only waits for blocks that are already running, so this finishes even if no worker is free.
+static void parallel_for(size_t count, std::function<void(size_t, size_t)> fn)
+{
+	struct work {
+		std::function<void(size_t, size_t)> fn;
+		size_t                              count;
+		size_t                              block;
+		std::atomic<size_t>                 next;
+		std::mutex                          lock;
+		std::condition_variable             finished;
+		size_t                              remaining;
+	};
+
+	if (count == 0) {
+		return;
+	}
+
+	std::shared_ptr<util::threadpool> pool    = util::threadpool::get();
+	size_t                            threads = pool ? std::min(pool->get_limit(), count) : 1;
+
+	auto w       = std::make_shared<work>();
+	w->fn        = fn;
+	w->count     = count;
+	w->block     = (count + threads - 1) / threads;
+	w->next      = 0;
+	w->remaining = (count + w->block - 1) / w->block;
+
+	auto run = [](std::shared_ptr<work> w) {
+		for (size_t begin = w->block * w->next++; begin < w->count; begin = w->block * w->next++) {
+			w->fn(begin, std::min(begin + w->block, w->count));
+
+			std::unique_lock<std::mutex> ulock(w->lock);
+			if (--w->remaining == 0) {
+				w->finished.notify_all();
+			}
+		}
+	};
+	for (size_t n = 1; n < threads; n++) {
+		pool->push(std::bind(run, w));
+	}
+	run(w);
+
+	std::unique_lock<std::mutex> ulock(w->lock);
+	w->finished.wait(ulock, [&w]() { return w->remaining == 0; });
+}
+
+// Squared distance and position of the nearest site for every pixel, for one kind of site.
+struct transform_result {
+	std::vector<float_t>  distance;
+	std::vector<uint32_t> nearest_x;
+	std::vector<uint32_t> nearest_y;
+};
+
+static void transform(std::vector<uint8_t> const& sites, uint32_t width, uint32_t height, transform_result& result,
+					  std::atomic<bool> const& cancel)
+{
+	const int32_t infinite = int32_t(width + height);
+
+	// Columns: Distance to the nearest site in the same column. Both scans walk entire rows at once, so that the
+	//  inner loop has no dependencies and can be vectorized by the compiler.
+	std::vector<int32_t> g(size_t(width) * height);
+	std::vector<int32_t> row(size_t(width) * height);
+	parallel_for(width, [&](size_t x0, size_t x1) {
+		for (size_t x = x0; x < x1; x++) {
+			g[x]   = sites[x] ? 0 : infinite;
+			row[x] = 0;
+		}
+		for (size_t y = 1; (y < height) && !cancel; y++) {
+			size_t here = y * width, above = here - width;
+			for (size_t x = x0; x < x1; x++) {
+				bool site     = sites[here + x] != 0;
+				g[here + x]   = site ? 0 : std::min(g[above + x] + 1, infinite);
+				row[here + x] = site ? int32_t(y) : row[above + x];
+			}
+		}
+		for (size_t y = height - 1; (y > 0) && !cancel; y--) {
+			size_t here = (y - 1) * width, below = here + width;
+			for (size_t x = x0; x < x1; x++) {
+				bool closer   = (g[below + x] + 1) < g[here + x];
+				g[here + x]   = closer ? (g[below + x] + 1) : g[here + x];
+				row[here + x] = closer ? row[below + x] : row[here + x];
+			}
+		}
+	});
+
+	// Rows: Lower envelope of the parabolas rooted at each column distance.
+	result.distance.resize(size_t(width) * height);
+	result.nearest_x.resize(size_t(width) * height);
+	result.nearest_y.resize(size_t(width) * height);
+	parallel_for(height, [&](size_t y0, size_t y1) {
+		std::vector<double_t> f(width);
+		std::vector<uint32_t> v(width);
+		std::vector<double_t> z(size_t(width) + 1);
+		for (size_t y = y0; (y < y1) && !cancel; y++) {
+			size_t offset = y * width;
+			for (size_t x = 0; x < width; x++) {
+				f[x] = double_t(g[offset + x]) * double_t(g[offset + x]);
+			}
+
+			size_t k = 0;
+			v[0]     = 0;
+			z[0]     = -std::numeric_limits<double_t>::infinity();
+			z[1]     = std::numeric_limits<double_t>::infinity();
+			for (size_t q = 1; q < width; q++) {
+				// Parabolas are removed until the new one intersects the envelope to the right of the last one. As
+				//  z[0] is negative infinity, this always stops at the first one.
+				double_t s;
+				while (true) {
+					size_t p = v[k];
+					s        = ((f[q] + double_t(q * q)) - (f[p] + double_t(p * p))) / (2.0 * double_t(q - p));
+					if (s > z[k]) {
+						break;
+					}
+					k--;
+				}
+				k++;
+				v[k]     = uint32_t(q);
+				z[k]     = s;
+				z[k + 1] = std::numeric_limits<double_t>::infinity();
+			}
+
+			k = 0;
+			for (size_t q = 0; q < width; q++) {
+				while (z[k + 1] < double_t(q)) {
+					k++;
+				}
+				size_t   p                   = v[k];
+				double_t dx                  = double_t(q) - double_t(p);
+				result.distance[offset + q]  = float_t(dx * dx + f[p]);
+				result.nearest_x[offset + q] = uint32_t(p);
+				result.nearest_y[offset + q] = uint32_t(row[offset + p]);
+			}
+		}
+	});
+}
+
+gfx::distance_field::distance_field(std::string file, uint32_t width, uint32_t height, float_t threshold)
+	: _file(file), _width(std::max(width, 1u)), _height(std::max(height, 1u)), _threshold(threshold),
+	  _state(std::make_shared<state>())
+{
+	_state->cancel = false;
+	_state->ready  = false;
+	_state->failed = false;
+
+	// The task only shares the state, so that it can finish on its own after the field is gone.
+	std::shared_ptr<util::threadpool> pool = util::threadpool::get();
+	if (!pool) {
+		_state->failed = true;
+		return;
+	}
+	pool->push(std::bind(&gfx::distance_field::generate, _state, _file, _width, _height, _threshold), field_jobs);
+}
+
+gfx::distance_field::~distance_field()
+{
+	// Fields are usually released on the graphics thread, which must never wait for a transform to finish.
+	_state->cancel = true;
+	if (_texture) {
+		auto gctx = gs::context();
+		_texture.reset();
+	}
+}
+
+void gfx::distance_field::wait_for_jobs()
+{
+	field_jobs->wait();
+}
+
+bool gfx::distance_field::has_failed()
+{
+	return _state->failed;
+}
+
+std::shared_ptr<gs::texture> gfx::distance_field::get_texture()
+{
+	if (!_state->ready) {
+		return nullptr;
+	}
+
+	std::unique_lock<std::mutex> ulock(_lock);
+	if (!_texture) {
+		std::unique_lock<std::mutex> slock(_state->lock);
+		if (!_state->data.empty()) {
+			auto           gctx = gs::context();
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(_state->data.data());
+			_texture = std::make_shared<gs::texture>(_width, _height, GS_RGBA32F, 1, &data, gs::texture::flags::None);
+
+			// The field is no longer needed once it is on the GPU.
+			std::vector<float_t>().swap(_state->data);
+		}
+	}
+	return _texture;
+}
+
+void gfx::distance_field::generate(std::shared_ptr<state> job, std::string file, uint32_t width,
+								   uint32_t height, float_t threshold)
+{
+	// Fields that were released while queued are skipped entirely.
+	if (job->cancel) {
+		return;
+	}
+
+	gs_color_format format = GS_UNKNOWN;
+	uint32_t        img_w = 0, img_h = 0;
+	uint8_t*        image = gs_create_texture_file_data(file.c_str(), &format, &img_w, &img_h);
+	if (!image || (img_w == 0) || (img_h == 0)) {
+		P_LOG_ERROR("<gfx::distance_field> Failed to load image '%s'.", file.c_str());
+		bfree(image);
+		job->failed = true;
+		return;
+	}
+
+	// Classify the pixels at the resolution of the field, the same way as sdf-producer.effect does.
+	bool                 has_alpha       = (format == GS_RGBA) || (format == GS_BGRA);
+	uint8_t              alpha_threshold = uint8_t(std::min(std::max(threshold * 255.0f, 0.0f), 255.0f));
+	std::vector<uint8_t> inside(size_t(width) * height);
+	std::vector<uint8_t> outside(size_t(width) * height);
+	for (size_t y = 0; y < height; y++) {
+		size_t sy = std::min(size_t((y + 0.5) * img_h / height), size_t(img_h - 1));
+		for (size_t x = 0; x < width; x++) {
+			size_t  sx    = std::min(size_t((x + 0.5) * img_w / width), size_t(img_w - 1));
+			uint8_t alpha = has_alpha ? image[(sy * img_w + sx) * 4 + 3] : 255;
+			bool    solid = alpha > alpha_threshold;
+
+			inside[y * width + x]  = solid ? 1 : 0;
+			outside[y * width + x] = solid ? 0 : 1;
+		}
+	}
+	bfree(image);
+
+	// Outside pixels need the distance to the nearest inside pixel and the other way around.
+	transform_result to_inside, to_outside;
+	transform(inside, width, height, to_inside, job->cancel);
+	if (job->cancel) {
+		return;
+	}
+	transform(outside, width, height, to_outside, job->cancel);
+	if (job->cancel) {
+		return;
+	}
+
+	std::vector<float_t> data(size_t(width) * height * 4);
+	for (size_t idx = 0, end = size_t(width) * height; idx < end; idx++) {
+		bool              solid  = inside[idx] != 0;
+		transform_result& source = solid ? to_outside : to_inside;
+
+		float_t distance  = std::min(float_t(sqrt(source.distance[idx])), float_t(MAX_DISTANCE));
+		data[idx * 4 + 0] = solid ? 0.0f : float_t(distance / MAX_DISTANCE);
+		data[idx * 4 + 1] = solid ? float_t(distance / MAX_DISTANCE) : 0.0f;
+		data[idx * 4 + 2] = (float_t(source.nearest_x[idx]) + 0.5f) / float_t(width);
+		data[idx * 4 + 3] = (float_t(source.nearest_y[idx]) + 0.5f) / float_t(height);
+	}
+
+	{
+		std::unique_lock<std::mutex> ulock(job->lock);
+		job->data.swap(data);
+	}
+	job->ready = true;
+}
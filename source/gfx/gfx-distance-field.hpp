@@ -0,0 +1,69 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "obs/gs/gs-texture.hpp"
+
+namespace gfx {
+	// Exact Euclidean distance field of an image file.
+	//
+	// The image is loaded and transformed on the shared thread pool, using the separable algorithm by Meijster et al.
+	//  for the columns and the lower envelope of parabolas by Felzenszwalb and Huttenlocher for the rows. The result
+	//  has the same layout as the one of sdf-producer.effect and is uploaded to the GPU on the first call to
+	//  get_texture() after it is done. Destroying the field cancels the task instead of waiting for it.
+	class distance_field {
+		struct state {
+			std::atomic<bool>    cancel;
+			std::atomic<bool>    ready;
+			std::atomic<bool>    failed;
+			std::mutex           lock;
+			std::vector<float_t> data;
+		};
+
+		std::string _file;
+		uint32_t    _width;
+		uint32_t    _height;
+		float_t     _threshold;
+
+		std::shared_ptr<state>       _state;
+		std::mutex                   _lock;
+		std::shared_ptr<gs::texture> _texture;
+
+		public:
+		distance_field(std::string file, uint32_t width, uint32_t height, float_t threshold);
+		~distance_field();
+
+		// Waits until all fields have finished or cancelled their task, for before the plugin is unloaded.
+		static void wait_for_jobs();
+
+		// Returns true if the field could not be generated, for example because the file is not an image.
+		bool has_failed();
+
+		// Returns nullptr until the field is done.
+		std::shared_ptr<gs::texture> get_texture();
+
+		private:
+		static void generate(std::shared_ptr<state> job, std::string file, uint32_t width, uint32_t height,
+							 float_t threshold);
+	};
+} // namespace gfx
@@ -0,0 +1,191 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-texture-probe.hpp"
+#include <algorithm>
+#include <cstring>
+#include "obs/gs/gs-helper.hpp"
+
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <graphics/vec2.h>
+#include <obs.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#define PROBE_SIZE 16
+#define PROBE_LEVELS 12
+#define PROBE_FIRST_STEP 8 // Reduction of the first level, which keeps the largest probe level small.
+
+gfx::texture_probe::texture_probe() : _index(0), _last(0), _mark_pending(false)
+{
+	_stage.fill(nullptr);
+	_staged.fill(false);
+
+	auto gctx = gs::context();
+	_rt.resize(PROBE_LEVELS);
+	for (auto& rt : _rt) {
+		rt = std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
+	}
+}
+
+gfx::texture_probe::~texture_probe()
+{
+	auto gctx = gs::context();
+	for (auto& stage : _stage) {
+		if (stage) {
+			gs_stagesurface_destroy(stage);
+		}
+	}
+	_rt.clear();
+}
+
+bool gfx::texture_probe::probe(std::shared_ptr<gs::texture> input)
+{
+	gs_effect_t* default_effect = obs_get_base_effect(obs_base_effect::OBS_EFFECT_DEFAULT);
+	gs_effect_t* area_effect    = obs_get_base_effect(obs_base_effect::OBS_EFFECT_AREA);
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	// Average the input down to a tiny probe. The probe is kept in full float precision, so that even a small
+	//  change in a large block of pixels still changes its average. The first level is reduced by a larger step
+	//  with the area filter, which still weighs every pixel, and the remaining ones in exact 2x2 steps.
+	std::shared_ptr<gs::texture> tex = input;
+	for (size_t n = 0; n < PROBE_LEVELS; n++) {
+		if ((n > 0) && (tex->get_width() <= PROBE_SIZE) && (tex->get_height() <= PROBE_SIZE)) {
+			break;
+		}
+
+		// Round up, so that the last row and column of odd sizes still contribute to the probe.
+		uint32_t     step   = (n == 0) ? PROBE_FIRST_STEP : 2;
+		uint32_t     width  = std::max((tex->get_width() + step - 1) / step, 1u);
+		uint32_t     height = std::max((tex->get_height() + step - 1) / step, 1u);
+		gs_effect_t* effect = ((n == 0) && area_effect) ? area_effect : default_effect;
+
+		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), tex->get_object());
+		if (gs_eparam_t* param = gs_effect_get_param_by_name(effect, "base_dimension"); param != nullptr) {
+			vec2 base;
+			vec2_set(&base, float_t(tex->get_width()), float_t(tex->get_height()));
+			gs_effect_set_vec2(param, &base);
+		}
+		if (gs_eparam_t* param = gs_effect_get_param_by_name(effect, "base_dimension_i"); param != nullptr) {
+			vec2 base_i;
+			vec2_set(&base_i, 1.f / float_t(tex->get_width()), 1.f / float_t(tex->get_height()));
+			gs_effect_set_vec2(param, &base_i);
+		}
+		{
+			auto op = _rt[n]->render(width, height);
+			gs_ortho(0, (float)width, 0, (float)height, -1, 1);
+			while (gs_effect_loop(effect, "Draw")) {
+				gs_draw_sprite(tex->get_object(), 0, width, height);
+			}
+		}
+
+		tex = _rt[n]->get_texture();
+	}
+
+	gs_blend_state_pop();
+
+	// Stage the probe of this frame, and read back the one staged during the previous frame. Reading back the
+	//  current probe would stall until the GPU caught up with all the work queued so far.
+	uint32_t         width  = tex->get_width();
+	uint32_t         height = tex->get_height();
+	gs_stagesurf_t*& stage  = _stage[_index];
+	if (stage && ((gs_stagesurface_get_width(stage) != width) || (gs_stagesurface_get_height(stage) != height))) {
+		gs_stagesurface_destroy(stage);
+		stage = nullptr;
+	}
+	if (!stage) {
+		stage = gs_stagesurface_create(width, height, GS_RGBA32F);
+	}
+	if (stage) {
+		gs_stage_texture(stage, tex->get_object());
+	}
+	_staged[_index] = (stage != nullptr);
+	_last           = _index;
+	_index          = (_index + 1) % _stage.size();
+
+	std::vector<uint8_t> probe;
+	if (!_staged[_index] || !read(_stage[_index], probe)) {
+		_data.clear();
+		_mark_pending = false;
+		return true;
+	}
+	if (_mark_pending) {
+		_mark         = probe;
+		_mark_pending = false;
+	}
+
+	bool changed = (probe != _data);
+	_data.swap(probe);
+	return changed;
+}
+
+void gfx::texture_probe::mark()
+{
+	_mark.clear();
+	_mark_pending = _staged[_last];
+}
+
+bool gfx::texture_probe::matches_mark()
+{
+	if (_mark_pending || _mark.empty() || _data.empty()) {
+		return false;
+	}
+	return _data == _mark;
+}
+
+bool gfx::texture_probe::read(gs_stagesurf_t* stage, std::vector<uint8_t>& probe)
+{
+	uint8_t* data     = nullptr;
+	uint32_t linesize = 0;
+	if (!stage || !gs_stagesurface_map(stage, &data, &linesize)) {
+		return false;
+	}
+
+	size_t row  = size_t(gs_stagesurface_get_width(stage)) * sizeof(float_t) * 4;
+	size_t rows = size_t(gs_stagesurface_get_height(stage));
+	probe.resize(row * rows);
+	for (size_t y = 0; y < rows; y++) {
+		memcpy(probe.data() + y * row, data + y * linesize, row);
+	}
+	gs_stagesurface_unmap(stage);
+	return true;
+}
+
+void gfx::texture_probe::reset()
+{
+	_staged.fill(false);
+	_data.clear();
+	_mark.clear();
+	_mark_pending = false;
+}
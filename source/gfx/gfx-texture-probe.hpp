@@ -0,0 +1,71 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <vector>
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <graphics/graphics.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace gfx {
+	// Detects changes in a texture from one frame to the next.
+	//
+	// The texture is averaged down to a tiny probe on the GPU, which is read back one frame later so that the
+	//  read back never stalls. Changes are therefore reported with one frame of delay. As the probe only holds
+	//  block averages, a change that keeps the average of every block the same is not detected at all.
+	class texture_probe {
+		std::vector<std::shared_ptr<gs::rendertarget>> _rt;
+		std::array<gs_stagesurf_t*, 2>                 _stage;
+		std::array<bool, 2>                            _staged;
+		size_t                                         _index;
+		size_t                                         _last;
+		std::vector<uint8_t>                           _data;
+		std::vector<uint8_t>                           _mark;
+		bool                                           _mark_pending;
+
+		bool read(gs_stagesurf_t* stage, std::vector<uint8_t>& data);
+
+		public:
+		texture_probe();
+		~texture_probe();
+
+		// Probe the texture, returns true if it may have changed since the last probe.
+		bool probe(std::shared_ptr<gs::texture> input);
+
+		// Mark the latest probe, its content is read back along with the next probe.
+		void mark();
+
+		// Returns true if the probe read back last is identical to the marked one. Like probe(), this lags one frame
+		//  behind the texture.
+		bool matches_mark();
+
+		// Forget all previous probes, for when probes were skipped.
+		void reset();
+	};
+} // namespace gfx
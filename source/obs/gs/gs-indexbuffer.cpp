@@ -18,6 +18,8 @@
  */
 
 #include "gs-indexbuffer.hpp"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include "gs-limits.hpp"
 #include "obs/gs/gs-helper.hpp"
@@ -35,20 +37,24 @@
 gs::index_buffer::index_buffer(uint32_t maximumVertices)
 {
 	this->reserve(maximumVertices);
+
+	// The index buffer takes ownership of the memory it is created with, so it can not be the memory of this vector.
+	uint32_t* indices = static_cast<uint32_t*>(bzalloc(sizeof(uint32_t) * maximumVertices));
+
 	auto gctx     = gs::context();
-	_index_buffer = gs_indexbuffer_create(gs_index_type::GS_UNSIGNED_LONG, this->data(), maximumVertices, GS_DYNAMIC);
+	_index_buffer = gs_indexbuffer_create(gs_index_type::GS_UNSIGNED_LONG, indices, maximumVertices, GS_DYNAMIC);
 }
 
 gs::index_buffer::index_buffer() : index_buffer(MAXIMUM_VERTICES) {}
 
 gs::index_buffer::index_buffer(index_buffer& other) : index_buffer((uint32_t)other.size())
 {
-	std::copy(other.begin(), other.end(), this->end());
+	this->assign(other.begin(), other.end());
 }
 
 gs::index_buffer::index_buffer(std::vector<uint32_t>& other) : index_buffer((uint32_t)other.size())
 {
-	std::copy(other.begin(), other.end(), this->end());
+	this->assign(other.begin(), other.end());
 }
 
 gs::index_buffer::~index_buffer()
@@ -65,7 +71,9 @@ gs_indexbuffer_t* gs::index_buffer::get()
 gs_indexbuffer_t* gs::index_buffer::get(bool refreshGPU)
 {
 	if (refreshGPU) {
-		auto gctx = gs::context();
+		auto   gctx  = gs::context();
+		size_t count = std::min(this->size(), gs_indexbuffer_get_num_indices(_index_buffer));
+		std::memcpy(gs_indexbuffer_get_data(_index_buffer), this->data(), count * sizeof(uint32_t));
 		gs_indexbuffer_flush(_index_buffer);
 	}
 	return _index_buffer;
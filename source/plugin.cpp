@@ -29,10 +29,14 @@
 #include "obs/obs-source-tracker.hpp"
 #include "sources/source-mirror.hpp"
 #include "sources/source-shader.hpp"
+#include "util-threadpool.hpp"
 
 MODULE_EXPORT bool obs_module_load(void) try {
 	P_LOG_INFO("Loading Version %s", STREAMEFFECTS_VERSION_STRING);
 
+	// Initialize Thread Pool
+	util::threadpool::initialize();
+
 	// Initialize Source Tracker
 	obs::source_tracker::initialize();
 
@@ -73,6 +77,9 @@ MODULE_EXPORT void obs_module_unload(void) try {
 
 	// Clean up Source Tracker
 	obs::source_tracker::finalize();
+
+	// Clean up Thread Pool
+	util::threadpool::finalize();
 } catch (...) {
 	P_LOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
 }
@@ -18,13 +18,15 @@
 */
 
 #include "source-mirror.hpp"
-#include <bitset>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <functional>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <vector>
+#include "obs/gs/gs-helper.hpp"
 #include "obs/obs-source-tracker.hpp"
 #include "obs/obs-tools.hpp"
 #include "strings.hpp"
@@ -53,6 +55,7 @@
 #define ST_SCALING_METHOD_BILINEAR ST_SCALING ".Method.Bilinear"
 #define ST_SCALING_METHOD_BICUBIC ST_SCALING ".Method.Bicubic"
 #define ST_SCALING_METHOD_LANCZOS ST_SCALING ".Method.Lanczos"
+#define ST_SCALING_METHOD_AREA ST_SCALING ".Method.Area"
 #define ST_SCALING_SIZE ST_SCALING ".Size"
 #define ST_SCALING_TRANSFORMKEEPORIGINAL ST_SCALING ".TransformKeepOriginal"
 #define ST_SCALING_BOUNDS ST_SCALING ".Bounds"
@@ -63,9 +66,13 @@
 #define ST_SCALING_BOUNDS_FILLHEIGHT ST_SCALING ".Bounds.FillHeight"
 #define ST_SCALING_ALIGNMENT ST_SCALING ".Alignment"
 
+#define AUDIO_RING_DURATION_MS 500 // Audio that may be queued before packets are dropped.
+#define AUDIO_WAKEUP_MS 5 // Upper bound for a missed wake up of the audio dispatch thread.
+
 void source::mirror::mirror_instance::release()
 {
-	_source_item.reset();
+	_cache_texture.reset();
+	_cache_renderer.reset();
 	if (_source) {
 		_source->events.rename.clear();
 		_source->events.audio_data.clear();
@@ -88,15 +95,17 @@ void source::mirror::mirror_instance::acquire(std::string source_name)
 	}
 
 	// We seem to have a true link to a source, let's add it to our rendering.
-	obs_sceneitem_t* item = obs_scene_add(obs_scene_from_source(_scene.get()), source.get());
-	if (!item) { // Can't add this source to our scene, probably due to one or more issues with it.
+	std::shared_ptr<gfx::source_texture> renderer;
+	try {
+		renderer = std::make_shared<gfx::source_texture>(source.get(), _self);
+	} catch (...) { // Can't render this source, most likely because it contains us.
 		return;
 	}
 
 	// It seems everything has worked out, so let's update our state.
-	_source      = std::make_shared<obs::source>(source.get(), true, true);
-	_source_name = obs_source_get_name(source.get());
-	_source_item = std::shared_ptr<obs_sceneitem_t>(item, [](obs_sceneitem_t* ref) { obs_sceneitem_remove(ref); });
+	_source         = std::make_shared<obs::source>(source.get(), true, true);
+	_source_name    = obs_source_get_name(source.get());
+	_cache_renderer = renderer;
 
 	// And let's hook up all our events too.
 	_source->events.rename.add(std::bind(&source::mirror::mirror_instance::on_source_rename, this, _1, _2, _3));
@@ -106,43 +115,34 @@ void source::mirror::mirror_instance::acquire(std::string source_name)
 
 source::mirror::mirror_instance::mirror_instance(obs_data_t* settings, obs_source_t* self)
 	: obs::source_instance(settings, self), _source(), _source_name(), _audio_enabled(), _audio_layout(),
-	  _audio_kill_thread(), _audio_have_output(), _rescale_enabled(), _rescale_width(), _rescale_height(),
-	  _rescale_keep_orig_size(), _rescale_type(), _rescale_bounds(), _rescale_alignment(), _cache_enabled(),
-	  _cache_rendered()
+	  _rescale_enabled(), _rescale_width(), _rescale_height(), _rescale_keep_orig_size(), _rescale_type(),
+	  _rescale_bounds(), _rescale_alignment(), _cache_enabled(), _cache_rendered()
 {
-	// Create Internal Scene
-	_scene = std::shared_ptr<obs_source_t>(obs_scene_get_source(obs_scene_create_private("")),
-										   [](obs_source_t* ref) { obs_source_release(ref); });
-
-	// Create Cache Renderer
-	_cache_renderer = std::make_shared<gfx::source_texture>(_scene.get(), _self);
-
-	// Spawn Audio Thread
-	/// ToDo: Use ThreadPool for this?
-	_audio_thread = std::thread(std::bind(&source::mirror::mirror_instance::audio_output_cb, this));
+	// Create Rescaling Resources
+	_rescale_rt            = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_rescale_point_sampler = std::make_shared<gs::sampler>();
+	_rescale_point_sampler->set_filter(GS_FILTER_POINT);
+	_rescale_point_sampler->set_address_mode_u(GS_ADDRESS_CLAMP);
+	_rescale_point_sampler->set_address_mode_v(GS_ADDRESS_CLAMP);
 }
 
 source::mirror::mirror_instance::~mirror_instance()
 {
 	release();
 
-	// Kill Audio Thread
-	_audio_kill_thread = true;
-	_audio_notify.notify_all();
-	if (_audio_thread.joinable()) {
-		_audio_thread.join();
-	}
-
-	// Delete Cache Renderer
-	_cache_renderer.reset();
+	// Stop Audio Dispatch
+	mirror_factory::get()->remove_audio_instance(this);
+	std::atomic_store(&_audio_ring, std::shared_ptr<util::audio_ring>());
 
-	// Delete Internal Scene
-	_scene.reset();
+	// Delete Rescaling Resources
+	auto gctx = gs::context();
+	_rescale_point_sampler.reset();
+	_rescale_rt.reset();
 }
 
 uint32_t source::mirror::mirror_instance::get_width()
 {
-	if (!_source || !_source_item || !(obs_source_get_output_flags(_source->get()) & OBS_SOURCE_VIDEO))
+	if (!_source || !(obs_source_get_output_flags(_source->get()) & OBS_SOURCE_VIDEO))
 		return 0;
 	if (_rescale_enabled && _rescale_width > 0 && !_rescale_keep_orig_size)
 		return _rescale_width;
@@ -151,7 +151,7 @@ uint32_t source::mirror::mirror_instance::get_width()
 
 uint32_t source::mirror::mirror_instance::get_height()
 {
-	if (!_source || !_source_item || !(obs_source_get_output_flags(_source->get()) & OBS_SOURCE_VIDEO))
+	if (!_source || !(obs_source_get_output_flags(_source->get()) & OBS_SOURCE_VIDEO))
 		return 0;
 	if (_rescale_enabled && _rescale_height > 0 && !_rescale_keep_orig_size)
 		return _rescale_height;
@@ -189,6 +189,28 @@ void source::mirror::mirror_instance::update(obs_data_t* data)
 	// Audio
 	this->_audio_enabled = obs_data_get_bool(data, ST_SOURCE_AUDIO);
 	this->_audio_layout  = static_cast<speaker_layout>(obs_data_get_int(data, ST_SOURCE_AUDIO_LAYOUT));
+	if (this->_audio_enabled && (this->_audio_layout != SPEAKERS_UNKNOWN)) {
+		// Only remapped audio is decoupled through the ring, everything else is forwarded directly. The ring is
+		//  allocated here, so that forwarding audio never has to allocate.
+		if (!std::atomic_load(&_audio_ring)) {
+			if (audio_t* aud = obs_get_audio(); aud != nullptr) {
+				if (audio_output_info const* aoi = audio_output_get_info(aud); aoi != nullptr) {
+					size_t blocks =
+						(size_t(aoi->samples_per_sec) * AUDIO_RING_DURATION_MS / 1000 + AUDIO_OUTPUT_FRAMES - 1)
+						/ AUDIO_OUTPUT_FRAMES;
+					std::atomic_store(&_audio_ring,
+									  std::make_shared<util::audio_ring>(blocks, get_audio_channels(aoi->speakers),
+																		 AUDIO_OUTPUT_FRAMES));
+				}
+			}
+		}
+		mirror_factory::get()->add_audio_instance(this);
+	} else {
+		// Stop the dispatch before dropping the ring, so that queued audio is not replayed once remapping is used
+		//  again.
+		mirror_factory::get()->remove_audio_instance(this);
+		std::atomic_store(&_audio_ring, std::shared_ptr<util::audio_ring>());
+	}
 
 	// Rescaling
 	this->_rescale_enabled = obs_data_get_bool(data, ST_SCALING);
@@ -240,40 +262,128 @@ void source::mirror::mirror_instance::save(obs_data_t* data)
 	}
 }
 
-void source::mirror::mirror_instance::video_tick(float time)
+void source::mirror::mirror_instance::video_tick(float)
 {
-	if (_source_item && ((obs_source_get_output_flags(_source->get()) & OBS_SOURCE_VIDEO) != 0)) {
-		obs_transform_info info;
-
-		/// Position, Rotation, Scale, Alignment
-		vec2_set(&info.pos, 0, 0);
-		info.rot = 0;
-		vec2_set(&info.scale, 1., 1.);
-		info.alignment = OBS_ALIGN_LEFT | OBS_ALIGN_TOP;
-
-		/// Bounding Box
-		if (_rescale_enabled && _rescale_keep_orig_size) {
-			vec2_set(&info.bounds, static_cast<float_t>(_rescale_width), static_cast<float_t>(_rescale_height));
-		} else {
-			vec2_set(&info.bounds, static_cast<float_t>(get_width()), static_cast<float_t>(get_height()));
-		}
+	_cache_rendered = false;
+}
+
+std::shared_ptr<gs::texture> source::mirror::mirror_instance::rescale(std::shared_ptr<gs::texture> input)
+{
+	float_t cx = float_t(input->get_width());
+	float_t cy = float_t(input->get_height());
+	float_t bx = float_t(_rescale_width);
+	float_t by = float_t(_rescale_height);
+
+	// Size of the source within the bounds, matching what a scene item would do.
+	float_t sx = 1.f;
+	float_t sy = 1.f;
+	switch (_rescale_bounds) {
+	case OBS_BOUNDS_STRETCH:
+		sx = bx / cx;
+		sy = by / cy;
+		break;
+	case OBS_BOUNDS_SCALE_INNER:
+		sx = sy = std::min(bx / cx, by / cy);
+		break;
+	case OBS_BOUNDS_SCALE_OUTER:
+		sx = sy = std::max(bx / cx, by / cy);
+		break;
+	case OBS_BOUNDS_SCALE_TO_WIDTH:
+		sx = sy = bx / cx;
+		break;
+	case OBS_BOUNDS_SCALE_TO_HEIGHT:
+		sx = sy = by / cy;
+		break;
+	case OBS_BOUNDS_MAX_ONLY:
+		sx = sy = std::min(std::min(bx / cx, by / cy), 1.f);
+		break;
+	default:
+		break;
+	}
+	float_t width  = cx * sx;
+	float_t height = cy * sy;
+
+	// Position within the bounds.
+	float_t x = (bx - width) / 2.f;
+	float_t y = (by - height) / 2.f;
+	if (_rescale_alignment & OBS_ALIGN_LEFT) {
+		x = 0;
+	} else if (_rescale_alignment & OBS_ALIGN_RIGHT) {
+		x = bx - width;
+	}
+	if (_rescale_alignment & OBS_ALIGN_TOP) {
+		y = 0;
+	} else if (_rescale_alignment & OBS_ALIGN_BOTTOM) {
+		y = by - height;
+	}
 
-		info.bounds_alignment = _rescale_alignment;
-		info.bounds_type      = OBS_BOUNDS_STRETCH;
-		if (_rescale_enabled)
-			info.bounds_type = _rescale_bounds;
+	// Same effects as libobs uses for scale filtering, point and bilinear differ only by sampler.
+	gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	switch (_rescale_type) {
+	case OBS_SCALE_BICUBIC:
+		effect = obs_get_base_effect(OBS_EFFECT_BICUBIC);
+		break;
+	case OBS_SCALE_LANCZOS:
+		effect = obs_get_base_effect(OBS_EFFECT_LANCZOS);
+		break;
+	case OBS_SCALE_AREA:
+		effect = obs_get_base_effect(OBS_EFFECT_AREA);
+		break;
+	default:
+		break;
+	}
+
+	gs_eparam_t* image = gs_effect_get_param_by_name(effect, "image");
+	if (gs_eparam_t* param = gs_effect_get_param_by_name(effect, "base_dimension"); param != nullptr) {
+		vec2 base;
+		vec2_set(&base, cx, cy);
+		gs_effect_set_vec2(param, &base);
+	}
+	if (gs_eparam_t* param = gs_effect_get_param_by_name(effect, "base_dimension_i"); param != nullptr) {
+		vec2 base_i;
+		vec2_set(&base_i, 1.f / cx, 1.f / cy);
+		gs_effect_set_vec2(param, &base_i);
+	}
+	if (gs_eparam_t* param = gs_effect_get_param_by_name(effect, "undistort_factor"); param != nullptr) {
+		gs_effect_set_float(param, 1.f);
+	}
+	gs_effect_set_texture(image, input->get_object());
+	if (_rescale_type == OBS_SCALE_POINT) {
+		gs_effect_set_next_sampler(image, _rescale_point_sampler->get_object());
+	}
 
-		obs_sceneitem_set_info(_source_item.get(), &info);
-		obs_sceneitem_force_update_transform(_source_item.get());
-		obs_sceneitem_set_scale_filter(_source_item.get(), _rescale_enabled ? _rescale_type : OBS_SCALE_DISABLE);
+	{
+		GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_ITEM_TEXTURE, "rescale");
+		auto op = _rescale_rt->render(_rescale_width, _rescale_height);
+
+		vec4 black;
+		vec4_zero(&black);
+		gs_ortho(0, bx, 0, by, 0, 1);
+		gs_clear(GS_CLEAR_COLOR, &black, 0, 0);
+
+		gs_blend_state_push();
+		gs_reset_blend_state();
+		gs_enable_blending(false);
+		gs_matrix_push();
+		gs_matrix_identity();
+		gs_matrix_translate3f(x, y, 0);
+		gs_matrix_scale3f(width, height, 1.f);
+		while (gs_effect_loop(effect, "Draw")) {
+			gs_draw_sprite(nullptr, 0, 1, 1);
+		}
+		gs_matrix_pop();
+		gs_blend_state_pop();
+		GS_DEBUG_MARKER_END();
 	}
 
-	_cache_rendered = false;
+	std::shared_ptr<gs::texture> tex;
+	_rescale_rt->get_texture(tex);
+	return tex;
 }
 
 void source::mirror::mirror_instance::video_render(gs_effect_t* effect)
 {
-	if (!_source || !_source_item)
+	if (!_source || !_cache_renderer)
 		return;
 
 	if ((obs_source_get_output_flags(_source->get()) & OBS_SOURCE_VIDEO) == 0)
@@ -284,84 +394,58 @@ void source::mirror::mirror_instance::video_render(gs_effect_t* effect)
 	// Rendering depends on cached or uncached.
 	if (_cache_enabled || _rescale_enabled) {
 		if (!_cache_rendered) {
-			uint32_t width  = get_width();
-			uint32_t height = get_height();
-			if (_rescale_enabled) {
-				width  = _rescale_width;
-				height = _rescale_height;
-			}
-
-			if (!width || !height)
-				return;
-
-			try {
-				_cache_texture  = this->_cache_renderer->render(width, height);
-				_cache_rendered = true;
-			} catch (...) {
+			uint32_t width  = _source->width();
+			uint32_t height = _source->height();
+
+			_cache_texture.reset();
+			if (width && height) {
+				try {
+					_cache_texture = this->_cache_renderer->render(width, height);
+					if (_cache_texture && _rescale_enabled) {
+						_cache_texture = rescale(_cache_texture);
+					}
+					_cache_rendered = true;
+				} catch (...) {
+				}
 			}
 		}
 
-		if (!_cache_texture)
-			return;
-
-		if (!effect)
-			effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		if (_cache_texture) {
+			if (!effect)
+				effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 
-		GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_ITEM_TEXTURE, "render_cache");
-		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), _cache_texture->get_object());
-		while (gs_effect_loop(effect, "Draw")) {
-			gs_draw_sprite(nullptr, 0, get_width(), get_height());
+			GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_ITEM_TEXTURE, "render_cache");
+			gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), _cache_texture->get_object());
+			while (gs_effect_loop(effect, "Draw")) {
+				gs_draw_sprite(nullptr, 0, get_width(), get_height());
+			}
+			GS_DEBUG_MARKER_END();
 		}
-		GS_DEBUG_MARKER_END();
 	} else {
-		obs_source_video_render(_scene.get());
+		obs_source_video_render(_source->get());
 	}
 
 	GS_DEBUG_MARKER_END();
 }
 
-void source::mirror::mirror_instance::audio_output_cb() noexcept try {
-	std::unique_lock<std::mutex> ulock(this->_audio_lock_outputter);
-
-	while (!this->_audio_kill_thread) {
-		this->_audio_notify.wait(ulock, [this]() { return this->_audio_have_output || this->_audio_kill_thread; });
-
-		if (this->_audio_have_output) { // Get used audio element
-			std::shared_ptr<mirror_audio_data> mad;
-			{
-				std::lock_guard<std::mutex> capture_lock(this->_audio_lock_capturer);
-				if (_audio_data_queue.size() > 0) {
-					mad = _audio_data_queue.front();
-					_audio_data_queue.pop();
-				}
-				if (_audio_data_queue.size() == 0) {
-					this->_audio_have_output = false;
-				}
-			}
-
-			if (mad) {
-				ulock.unlock();
-				obs_source_output_audio(this->_self, &mad->audio);
-				ulock.lock();
+bool source::mirror::mirror_instance::audio_output()
+{
+	std::shared_ptr<util::audio_ring> ring = std::atomic_load(&_audio_ring);
+	if (!ring) {
+		return false;
+	}
 
-				{
-					std::lock_guard<std::mutex> capture_lock(this->_audio_lock_capturer);
-					_audio_data_free_queue.push(mad);
-				}
-			}
-		}
+	bool output = false;
+	for (util::audio_ring::block* block = ring->read_begin(); block; block = ring->read_begin()) {
+		obs_source_output_audio(this->_self, &block->audio);
+		ring->read_end();
+		output = true;
 	}
-} catch (const std::exception& ex) {
-	P_LOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
-} catch (...) {
-	P_LOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+	return output;
 }
 
 void source::mirror::mirror_instance::enum_active_sources(obs_source_enum_proc_t enum_callback, void* param)
 {
-	if (_scene) {
-		enum_callback(_self, _scene.get(), param);
-	}
 	if (_source) {
 		enum_callback(_self, _source->get(), param);
 	}
@@ -369,9 +453,6 @@ void source::mirror::mirror_instance::enum_active_sources(obs_source_enum_proc_t
 
 void source::mirror::mirror_instance::enum_all_sources(obs_source_enum_proc_t enum_callback, void* param)
 {
-	if (_scene) {
-		enum_callback(_self, _scene.get(), param);
-	}
 	if (_source) {
 		enum_callback(_self, _source->get(), param);
 	}
@@ -397,60 +478,52 @@ void source::mirror::mirror_instance::on_audio_data(obs::source*, const audio_da
 		return;
 	}
 
-	std::shared_ptr<mirror_audio_data> mad;
-	{ // Get free audio data element.
-		std::lock_guard<std::mutex> capture_lock(this->_audio_lock_capturer);
-		if (_audio_data_free_queue.size() > 0) {
-			mad = _audio_data_free_queue.front();
-			_audio_data_free_queue.pop();
-		} else {
-			mad = std::make_shared<mirror_audio_data>();
-			mad->data.resize(MAX_AUDIO_CHANNELS);
-			for (size_t idx = 0; idx < mad->data.size(); idx++) {
-				mad->data[idx].resize(AUDIO_OUTPUT_FRAMES);
-			}
-		}
-	}
-
-	{ // Copy data
-		std::bitset<8> layout;
+	if (this->_audio_layout == SPEAKERS_UNKNOWN) {
+		// Nothing about the packet changes, so forward it as is instead of copying it for the dispatch thread.
+		obs_source_audio packet = {};
 		for (size_t plane = 0; plane < MAX_AV_PLANES; plane++) {
-			float* samples = reinterpret_cast<float_t*>(audio->data[plane]);
-			if (!samples) {
-				mad->audio.data[plane] = nullptr;
-				continue;
-			}
-			layout.set(plane);
-
-			memcpy(mad->data[plane].data(), audio->data[plane], audio->frames * sizeof(float_t));
-			mad->audio.data[plane] = reinterpret_cast<uint8_t*>(mad->data[plane].data());
-		}
-		mad->audio.format          = aoi->format;
-		mad->audio.frames          = audio->frames;
-		mad->audio.timestamp       = audio->timestamp;
-		mad->audio.samples_per_sec = aoi->samples_per_sec;
-		if (this->_audio_layout != SPEAKERS_UNKNOWN) {
-			mad->audio.speakers = this->_audio_layout;
-		} else {
-			mad->audio.speakers = aoi->speakers;
+			packet.data[plane] = audio->data[plane];
 		}
+		packet.format          = aoi->format;
+		packet.frames          = audio->frames;
+		packet.timestamp       = audio->timestamp;
+		packet.samples_per_sec = aoi->samples_per_sec;
+		packet.speakers        = aoi->speakers;
+		obs_source_output_audio(this->_self, &packet);
+		return;
 	}
 
-	{ // Push used audio data element.
-		std::lock_guard<std::mutex> capture_lock(this->_audio_lock_capturer);
-		_audio_data_queue.push(mad);
+	// Drop the packet instead of waiting if the audio thread has fallen behind.
+	std::shared_ptr<util::audio_ring> ring  = std::atomic_load(&_audio_ring);
+	util::audio_ring::block*          block = ring ? ring->write_begin() : nullptr;
+	if (!block) {
+		return;
 	}
 
-	{ // Signal other side.
-		std::lock_guard<std::mutex> output_lock(this->_audio_lock_outputter);
-		this->_audio_have_output = true;
+	size_t channels = ring->get_channels();
+	size_t frames   = std::min<size_t>(audio->frames, ring->get_frames());
+	for (size_t plane = 0; plane < MAX_AV_PLANES; plane++) {
+		if ((plane >= channels) || !audio->data[plane]) {
+			block->audio.data[plane] = nullptr;
+			continue;
+		}
+
+		memcpy(block->planes[plane], audio->data[plane], frames * sizeof(float_t));
+		block->audio.data[plane] = reinterpret_cast<uint8_t*>(block->planes[plane]);
 	}
-	this->_audio_notify.notify_all();
+	block->audio.format          = aoi->format;
+	block->audio.frames          = uint32_t(frames);
+	block->audio.timestamp       = audio->timestamp;
+	block->audio.samples_per_sec = aoi->samples_per_sec;
+	block->audio.speakers        = this->_audio_layout;
+
+	ring->write_end();
+	mirror_factory::get()->notify_audio();
 }
 
 std::shared_ptr<source::mirror::mirror_factory> source::mirror::mirror_factory::factory_instance;
 
-source::mirror::mirror_factory::mirror_factory()
+source::mirror::mirror_factory::mirror_factory() : _audio_kill_thread(false)
 {
 	_info.id           = "obs-stream-effects-source-mirror";
 	_info.type         = OBS_SOURCE_TYPE_INPUT;
@@ -459,7 +532,46 @@ source::mirror::mirror_factory::mirror_factory()
 	obs_register_source(&_info);
 }
 
-source::mirror::mirror_factory::~mirror_factory() {}
+source::mirror::mirror_factory::~mirror_factory()
+{
+	{
+		std::lock_guard<std::mutex> lock(_audio_lock);
+		_audio_kill_thread = true;
+	}
+	_audio_notify.notify_all();
+	if (_audio_thread.joinable()) {
+		_audio_thread.join();
+	}
+}
+
+void source::mirror::mirror_factory::audio_dispatch_cb() noexcept try {
+	std::unique_lock<std::mutex> ulock(_audio_lock);
+
+	while (!_audio_kill_thread) {
+		// Instances are only removed while holding the lock, so none of them can go away during output.
+		bool idle = true;
+		for (auto instance : _audio_instances) {
+			if (instance->audio_output()) {
+				idle = false;
+			}
+		}
+		if (!idle) {
+			continue;
+		}
+
+		if (_audio_instances.empty()) {
+			_audio_notify.wait(ulock, [this]() { return _audio_kill_thread || !_audio_instances.empty(); });
+		} else {
+			// Capturing signals without taking the lock, so a wake up may be missed. The timeout bounds the delay in
+			//  that case.
+			_audio_notify.wait_for(ulock, std::chrono::milliseconds(AUDIO_WAKEUP_MS));
+		}
+	}
+} catch (const std::exception& ex) {
+	P_LOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
+} catch (...) {
+	P_LOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
 
 const char* source::mirror::mirror_factory::get_name()
 {
@@ -645,6 +757,8 @@ obs_properties_t* source::mirror::mirror_factory::get_properties2(source::mirror
 									  (int64_t)obs_scale_type::OBS_SCALE_BICUBIC);
 			obs_property_list_add_int(p, D_TRANSLATE(ST_SCALING_METHOD_LANCZOS),
 									  (int64_t)obs_scale_type::OBS_SCALE_LANCZOS);
+			obs_property_list_add_int(p, D_TRANSLATE(ST_SCALING_METHOD_AREA),
+									  (int64_t)obs_scale_type::OBS_SCALE_AREA);
 		}
 
 		{
@@ -690,3 +804,31 @@ obs_properties_t* source::mirror::mirror_factory::get_properties2(source::mirror
 
 	return pr;
 }
+
+void source::mirror::mirror_factory::add_audio_instance(source::mirror::mirror_instance* instance)
+{
+	{
+		std::lock_guard<std::mutex> lock(_audio_lock);
+		if (std::find(_audio_instances.begin(), _audio_instances.end(), instance) != _audio_instances.end()) {
+			return;
+		}
+		_audio_instances.push_back(instance);
+
+		// The dispatch thread is only spawned once audio is actually mirrored, and then shared by all instances.
+		if (!_audio_thread.joinable()) {
+			_audio_thread = std::thread(std::bind(&source::mirror::mirror_factory::audio_dispatch_cb, this));
+		}
+	}
+	_audio_notify.notify_all();
+}
+
+void source::mirror::mirror_factory::remove_audio_instance(source::mirror::mirror_instance* instance)
+{
+	std::lock_guard<std::mutex> lock(_audio_lock);
+	_audio_instances.remove(instance);
+}
+
+void source::mirror::mirror_factory::notify_audio()
+{
+	_audio_notify.notify_one();
+}
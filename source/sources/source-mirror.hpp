@@ -19,9 +19,9 @@
 
 #pragma once
 #include <condition_variable>
+#include <list>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 #include "gfx/gfx-source-texture.hpp"
@@ -30,6 +30,7 @@
 #include "obs/obs-source-factory.hpp"
 #include "obs/obs-source.hpp"
 #include "plugin.hpp"
+#include "util-audio-ring.hpp"
 
 // OBS
 #ifdef _MSC_VER
@@ -43,27 +44,15 @@
 
 namespace source {
 	namespace mirror {
-		struct mirror_audio_data {
-			obs_source_audio                  audio = {};
-			std::vector<std::vector<float_t>> data;
-		};
-
 		class mirror_instance : public obs::source_instance {
 			// Source
 			std::shared_ptr<obs::source> _source;
 			std::string                  _source_name;
 
 			// Audio
-			bool                                           _audio_enabled;
-			speaker_layout                                 _audio_layout;
-			std::condition_variable                        _audio_notify;
-			std::thread                                    _audio_thread;
-			bool                                           _audio_kill_thread;
-			bool                                           _audio_have_output;
-			std::mutex                                     _audio_lock_outputter;
-			std::mutex                                     _audio_lock_capturer;
-			std::queue<std::shared_ptr<mirror_audio_data>> _audio_data_queue;
-			std::queue<std::shared_ptr<mirror_audio_data>> _audio_data_free_queue;
+			bool                              _audio_enabled;
+			speaker_layout                    _audio_layout;
+			std::shared_ptr<util::audio_ring> _audio_ring; // Only accessed with std::atomic_load/atomic_store.
 
 			// Scaling
 			bool            _rescale_enabled;
@@ -74,20 +63,21 @@ namespace source {
 			obs_bounds_type _rescale_bounds;
 			uint32_t        _rescale_alignment;
 
+			std::shared_ptr<gs::rendertarget> _rescale_rt;
+			std::shared_ptr<gs::sampler>      _rescale_point_sampler;
+
 			// Caching
 			bool                                 _cache_enabled;
 			bool                                 _cache_rendered;
 			std::shared_ptr<gfx::source_texture> _cache_renderer;
 			std::shared_ptr<gs::texture>         _cache_texture;
 
-			// Scene
-			std::shared_ptr<obs_source_t>    _scene;
-			std::shared_ptr<obs_sceneitem_t> _source_item;
-
 			private:
 			void release();
 			void acquire(std::string source_name);
 
+			std::shared_ptr<gs::texture> rescale(std::shared_ptr<gs::texture> input);
+
 			public:
 			mirror_instance(obs_data_t* settings, obs_source_t* self);
 			virtual ~mirror_instance();
@@ -105,7 +95,7 @@ namespace source {
 			virtual void enum_active_sources(obs_source_enum_proc_t, void*) override;
 			virtual void enum_all_sources(obs_source_enum_proc_t, void*) override;
 
-			void audio_output_cb() noexcept;
+			bool audio_output();
 
 			void on_source_rename(obs::source* source, std::string new_name, std::string old_name);
 			void on_audio_data(obs::source* source, const audio_data* audio, bool muted);
@@ -115,6 +105,15 @@ namespace source {
 			: public obs::source_factory<source::mirror::mirror_factory, source::mirror::mirror_instance> {
 			static std::shared_ptr<source::mirror::mirror_factory> factory_instance;
 
+			// Audio Dispatch
+			std::mutex                                   _audio_lock;
+			std::condition_variable                      _audio_notify;
+			std::thread                                  _audio_thread;
+			bool                                         _audio_kill_thread;
+			std::list<source::mirror::mirror_instance*> _audio_instances;
+
+			void audio_dispatch_cb() noexcept;
+
 			public: // Singleton
 			static void initialize()
 			{
@@ -140,6 +139,13 @@ namespace source {
 			virtual void get_defaults2(obs_data_t* data) override;
 
 			virtual obs_properties_t* get_properties2(source::mirror::mirror_instance* data) override;
+
+			public:
+			void add_audio_instance(source::mirror::mirror_instance* instance);
+
+			void remove_audio_instance(source::mirror::mirror_instance* instance);
+
+			void notify_audio();
 		};
 	} // namespace mirror
 };    // namespace source
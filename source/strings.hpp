@@ -60,6 +60,7 @@
 #define S_BLUR_TYPE_GAUSSIAN "Blur.Type.Gaussian"
 #define S_BLUR_TYPE_GAUSSIAN_LINEAR "Blur.Type.GaussianLinear"
 #define S_BLUR_TYPE_DUALFILTERING "Blur.Type.DualFiltering"
+#define S_BLUR_TYPE_GAUSSIAN_BOX "Blur.Type.GaussianBox"
 
 #define S_BLUR_SUBTYPE_AREA "Blur.Subtype.Area"
 #define S_BLUR_SUBTYPE_DIRECTIONAL "Blur.Subtype.Directional"
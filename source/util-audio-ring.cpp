@@ -0,0 +1,91 @@
+/*
+* Modern effects for a modern Streamer
+* Copyright (C) 2017 Michael Fabian Dirks
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#include "util-audio-ring.hpp"
+#include <algorithm>
+
+util::audio_ring::audio_ring(size_t blocks, size_t channels, size_t frames)
+	: _channels(std::min<size_t>(std::max<size_t>(channels, 1), MAX_AV_PLANES)), _frames(frames), _mask(),
+	  _write(0), _read(0)
+{
+	// Round up to a power of two so that the monotonic positions can be wrapped with a mask.
+	size_t count = 1;
+	while (count < blocks) {
+		count <<= 1;
+	}
+	_mask = count - 1;
+
+	_samples.resize(count * _channels * _frames);
+	_blocks.resize(count);
+	for (size_t idx = 0; idx < count; idx++) {
+		block& blk = _blocks[idx];
+		blk.audio  = {};
+		for (size_t plane = 0; plane < MAX_AV_PLANES; plane++) {
+			if (plane < _channels) {
+				blk.planes[plane] = _samples.data() + (idx * _channels + plane) * _frames;
+			} else {
+				blk.planes[plane] = nullptr;
+			}
+		}
+	}
+}
+
+util::audio_ring::~audio_ring() {}
+
+size_t util::audio_ring::get_channels()
+{
+	return _channels;
+}
+
+size_t util::audio_ring::get_frames()
+{
+	return _frames;
+}
+
+bool util::audio_ring::empty()
+{
+	return _read.load(std::memory_order_acquire) == _write.load(std::memory_order_acquire);
+}
+
+util::audio_ring::block* util::audio_ring::write_begin()
+{
+	size_t write = _write.load(std::memory_order_relaxed);
+	if ((write - _read.load(std::memory_order_acquire)) > _mask) {
+		return nullptr;
+	}
+	return &_blocks[write & _mask];
+}
+
+void util::audio_ring::write_end()
+{
+	_write.store(_write.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+util::audio_ring::block* util::audio_ring::read_begin()
+{
+	size_t read = _read.load(std::memory_order_relaxed);
+	if (read == _write.load(std::memory_order_acquire)) {
+		return nullptr;
+	}
+	return &_blocks[read & _mask];
+}
+
+void util::audio_ring::read_end()
+{
+	_read.store(_read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
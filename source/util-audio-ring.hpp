@@ -0,0 +1,76 @@
+/*
+* Modern effects for a modern Streamer
+* Copyright (C) 2017 Michael Fabian Dirks
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#pragma once
+#include <atomic>
+#include <cinttypes>
+#include <vector>
+
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace util {
+	// Single-producer single-consumer ring of fixed-size planar float audio blocks.
+	//
+	// All sample memory is allocated up front, so pushing and popping never allocates and never blocks. The
+	//  producer fills the block returned by write_begin() and publishes it with write_end(), the consumer does the
+	//  same with read_begin() and read_end(). Both return nullptr instead of waiting if the ring is full or empty.
+	class audio_ring {
+		public:
+		struct block {
+			obs_source_audio audio;
+			float_t*         planes[MAX_AV_PLANES];
+		};
+
+		private:
+		size_t               _channels;
+		size_t               _frames;
+		size_t               _mask;
+		std::vector<float_t> _samples;
+		std::vector<block>   _blocks;
+
+		// Kept on separate cache lines so that producer and consumer do not invalidate each other.
+		alignas(64) std::atomic<size_t> _write;
+		alignas(64) std::atomic<size_t> _read;
+
+		public:
+		audio_ring(size_t blocks, size_t channels, size_t frames);
+		~audio_ring();
+
+		size_t get_channels();
+
+		size_t get_frames();
+
+		bool empty();
+
+		// Producer
+		block* write_begin();
+		void   write_end();
+
+		// Consumer
+		block* read_begin();
+		void   read_end();
+	};
+} // namespace util
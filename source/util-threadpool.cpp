@@ -0,0 +1,139 @@
+/*
+* Modern effects for a modern Streamer
+* Copyright (C) 2019 Michael Fabian Dirks
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#include "util-threadpool.hpp"
+#include <algorithm>
+#include "plugin.hpp"
+
+util::threadpool::group::group() : _count(0) {}
+
+util::threadpool::group::~group() {}
+
+void util::threadpool::group::begin()
+{
+	std::unique_lock<std::mutex> ulock(_lock);
+	_count++;
+}
+
+void util::threadpool::group::end()
+{
+	std::unique_lock<std::mutex> ulock(_lock);
+	_count--;
+	if (_count == 0) {
+		_done.notify_all();
+	}
+}
+
+void util::threadpool::group::wait()
+{
+	std::unique_lock<std::mutex> ulock(_lock);
+	_done.wait(ulock, [this]() { return _count == 0; });
+}
+
+util::threadpool::threadpool()
+	: _idle(0), _limit(std::max<size_t>(std::thread::hardware_concurrency(), 1)), _stop(false)
+{}
+
+util::threadpool::~threadpool()
+{
+	{
+		std::unique_lock<std::mutex> ulock(_lock);
+		_stop = true;
+	}
+	_notify.notify_all();
+	for (auto& worker : _workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+}
+
+size_t util::threadpool::get_limit()
+{
+	return _limit;
+}
+
+void util::threadpool::push(std::function<void()> task, std::shared_ptr<group> tasks)
+{
+	if (tasks) {
+		tasks->begin();
+		task = [task, tasks]() {
+			try {
+				task();
+			} catch (...) {
+				tasks->end();
+				throw;
+			}
+			tasks->end();
+		};
+	}
+
+	{
+		std::unique_lock<std::mutex> ulock(_lock);
+		_tasks.push_back(std::move(task));
+		if ((_idle == 0) && (_workers.size() < _limit)) {
+			_workers.emplace_back(&util::threadpool::work, this);
+		}
+	}
+	_notify.notify_one();
+}
+
+void util::threadpool::work() noexcept
+{
+	std::unique_lock<std::mutex> ulock(_lock);
+	while (true) {
+		if (_tasks.empty()) {
+			if (_stop) {
+				break;
+			}
+			_idle++;
+			_notify.wait(ulock, [this]() { return _stop || !_tasks.empty(); });
+			_idle--;
+			continue;
+		}
+
+		std::function<void()> task = std::move(_tasks.front());
+		_tasks.pop_front();
+		ulock.unlock();
+		try {
+			task();
+		} catch (const std::exception& ex) {
+			P_LOG_ERROR("<util::threadpool> Task failed with error(s): %s", ex.what());
+		} catch (...) {
+			P_LOG_ERROR("<util::threadpool> Task failed with an unknown error.");
+		}
+		ulock.lock();
+	}
+}
+
+static std::shared_ptr<util::threadpool> threadpool_instance = nullptr;
+
+void util::threadpool::initialize()
+{
+	threadpool_instance = std::make_shared<util::threadpool>();
+}
+
+void util::threadpool::finalize()
+{
+	threadpool_instance.reset();
+}
+
+std::shared_ptr<util::threadpool> util::threadpool::get()
+{
+	return threadpool_instance;
+}
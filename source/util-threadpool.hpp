@@ -0,0 +1,81 @@
+/*
+* Modern effects for a modern Streamer
+* Copyright (C) 2019 Michael Fabian Dirks
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#pragma once
+#include <cinttypes>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+	// Bounded pool of worker threads shared by all background work of the plugin.
+	//
+	// Workers are only spawned once tasks are pushed, up to one per hardware thread. Tasks may be pushed from
+	//  within other tasks, but must not be waited for before they started, as there may be no free worker to run
+	//  them.
+	class threadpool {
+		public:
+		// Counts the queued and running tasks of one kind, so that their owner can wait until all of them are done.
+		class group {
+			std::mutex              _lock;
+			std::condition_variable _done;
+			size_t                  _count;
+
+			public:
+			group();
+			~group();
+
+			void begin();
+			void end();
+
+			void wait();
+		};
+
+		private:
+		std::mutex                       _lock;
+		std::condition_variable          _notify;
+		std::list<std::function<void()>> _tasks;
+		std::vector<std::thread>         _workers;
+		size_t                           _idle;
+		size_t                           _limit;
+		bool                             _stop;
+
+		public:
+		threadpool();
+		~threadpool();
+
+		size_t get_limit();
+
+		// Queue a task, which is counted in tasks until it is done if given.
+		void push(std::function<void()> task, std::shared_ptr<group> tasks = nullptr);
+
+		private:
+		void work() noexcept;
+
+		public: // Singleton
+		static void initialize();
+
+		static void finalize();
+
+		static std::shared_ptr<util::threadpool> get();
+	};
+} // namespace util